@@ -14,6 +14,8 @@
 #include "MPU6050.hpp"
 #include "publisher.hpp"
 #include "logfile.hpp"
+#include "asynclogfile.hpp"
+#include "shmpublisher.hpp"
 #include "SensingBracelet.hpp"
 #include "libs/SerialStream.h"
 
@@ -28,8 +30,9 @@ void print_help()
 	cout<<"01) -h --help \t\t\t   : program help." <<endl;
     cout<<"02) -m --model [dataset] \t   : [dataset] models creation." <<endl;
 	cout<<"03) -l --load [dataset] \t   : load models in [dataset]." <<endl;
-	cout<<"04) -v --validate [model] [set] [n]:"
-		<<" validate [model] with [n] trials of [set]." <<endl;
+	cout<<"04) -v --validate [model] [set] [n] [k]:"
+		<<" validate [model] with [n] trials of [set]"
+		<<" (one window every [k] samples)." <<endl;
 	cout<<"05) -t --test [trial] \t\t   :"
 		<<" off-line classification of [trial]." <<endl;
 	cout<<"06) -c --classify [port] \t   :"
@@ -42,6 +45,27 @@ void print_help()
 		<<" on-line posture and fall detection in [port] stream." <<endl;
 	cout<<"10) -w --wearable [port] \t   :"
 		<<" on-line full analysis of [port] stream." <<endl;
+	cout<<"11) -s --streaming [model] [set] [n]:"
+		<<" compare streaming and per-window preprocessing." <<endl;
+	cout<<"12) -e --early [model] [set] [n] [k]:"
+		<<" validate [model] with early exit, report the savings." <<endl;
+	cout<<"13) -p --precision [model] [set] [n]:"
+		<<" compare double and single precision results." <<endl;
+	cout<<"14) -k --kernel [n] \t\t   :"
+		<<" per-point distance cost ([n] scans of a model)." <<endl;
+	cout<<"15) -x --convert [dataset] \t   :"
+		<<" write the binary model files and pack of [dataset]." <<endl;
+	cout<<"16) -f --filter [n] \t\t   :"
+		<<" scalar and SIMD gravity filter cost ([n] windows)." <<endl;
+	cout<<"17) -i --incremental [model] [set] [n]:"
+		<<" compare incremental and batch scoring." <<endl;
+	cout<<"18) -S --server [model] [set] [n]  :"
+		<<" classify [n] trials as concurrent wearers (server)." <<endl;
+	cout<<"Setup options (to be given before the one above):" <<endl;
+	cout<<"    -j --threads [n] \t\t   :"
+		<<" compare the models with [n] threads (default: 1)." <<endl;
+	cout<<"    -P --publisher [log|shm] \t   :"
+		<<" results on log.txt (default) or on the shared-memory ring." <<endl;
 
 	cout<<endl;
 	cout<<"Functions calls examples:" <<endl;
@@ -49,7 +73,8 @@ void print_help()
 	cout<<"02.1) ./HMPdetector -m" <<endl;
 	cout<<"02.2) ./HMPdetector -m Ovada" <<endl;
 	cout<<"03)   ./HMPdetector -l Ovada" <<endl;
-	cout<<"04)   ./HMPdetector -v climb Ovada 6" <<endl;
+	cout<<"04.1) ./HMPdetector -v climb Ovada 6" <<endl;
+	cout<<"04.2) ./HMPdetector -v climb Ovada 6 4" <<endl;
 	cout<<"05)   ./HMPdetector -t drink_drink_stand_sit_drink.txt" <<endl;
 	cout<<"06)   ./HMPdetector -c /dev/ttyUSB0" <<endl;
 	cout<<"07)   ./HMPdetector -r "
@@ -57,6 +82,15 @@ void print_help()
 	cout<<"08)   ./HMPdetector -B /dev/ttyUSB0" <<endl;
 	cout<<"09)   ./HMPdetector -b /dev/ttyUSB0" <<endl;
 	cout<<"10)   ./HMPdetector -w /dev/ttyUSB0" <<endl;
+	cout<<"11)   ./HMPdetector -s stand Sweden 12" <<endl;
+	cout<<"12)   ./HMPdetector -e climb Sweden 6" <<endl;
+	cout<<"13)   ./HMPdetector -p climb Sweden 6" <<endl;
+	cout<<"14)   ./HMPdetector -k 1000" <<endl;
+	cout<<"15)   ./HMPdetector -x Sweden" <<endl;
+	cout<<"16)   ./HMPdetector -f 1000" <<endl;
+	cout<<"17)   ./HMPdetector -i stand Sweden 12" <<endl;
+	cout<<"18)   ./HMPdetector -S climb Sweden 6" <<endl;
+	cout<<"      ./HMPdetector -j 4 -v climb Ovada 6" <<endl;
 
 	cout<<endl;
 	cout<<"Enjoy!"<<endl;
@@ -83,9 +117,9 @@ void completeWearable(char* port, SensingBracelet oneBr, SensingBelt oneBe)
 	string dF = oneBr.datasetFolder.substr(0,oneBr.datasetFolder.length()-1);
 	dF = dF.substr(9);
 	Classifier hC(dF);
-	mat window = zeros<mat>(hC.window_size, 3);
-	mat gravity = zeros<mat>(hC.window_size, 3);
-	mat body = zeros<mat>(hC.window_size, 3);
+	SampleBuffer window(hC.window_size);
+	mat gravity = zeros<mat>(3, hC.window_size);
+	mat body = zeros<mat>(3, hC.window_size);
 
 	// initialize the possibilities and past possibilities
 	for(int i = 0; i < oneBr.nbM; i++)
@@ -133,13 +167,13 @@ void completeWearable(char* port, SensingBracelet oneBr, SensingBelt oneBe)
 					actsample <<ax <<ay <<az;
 
 					// update the window of samples to be analyzed
-					hC.createWindow(actsample, window, hC.window_size, nS);
+					hC.createWindow(actsample, window, nS);
 					if (nS >= hC.window_size)
 					{
 						// analyze the window and compute the models possibilities
 						for(int i = 0; i < oneBr.nbM; i++)
 							past_poss[i] = poss[i];
-						hC.analyzeWindow(window, gravity, body);
+						hC.analyzeWindow(window.view(), gravity, body);
 						hC.compareAll(gravity, body, poss);
 
 						// publish the dynamic tuples
@@ -163,18 +197,48 @@ void completeWearable(char* port, SensingBracelet oneBr, SensingBelt oneBe)
 
 int main(int argc, char* argv[])
 {
+    // setup options (leading: the other options read their arguments by position)
+    int nT = 1;
+    string publisher = "log";
+    while (argc > 2)
+    {
+        string setup = argv[1];
+        if (setup == "-j" || setup == "--threads")
+            nT = max(1, atoi(argv[2]));
+        else if (setup == "-P" || setup == "--publisher")
+            publisher = argv[2];
+        else
+            break;
+        argv[2] = argv[0];
+        argv = argv + 2;
+        argc = argc - 2;
+    }
+
     // default setup choices
     cout<<endl;
     Device* dev = new MPU6050("SparkFun MPU6050");
     cout<<"Default "; dev->printInfo();
 	string dF = "Sweden";
     cout<<"Default Dataset: " <<dF <<endl;
-    Publisher* p = new LogFile("log.txt");
-    cout<<"Default "; p->printInfo();
+    Publisher* p;
+    if (publisher == "shm")
+        p = new ShmPublisher(SHM_RING_NAME);
+    else
+    {
+#ifdef HMP_ASYNC_LOG
+        // (static: the queued records are written at exit, whatever the option)
+        static AsyncLogFile logFile("log.txt");
+        p = &logFile;
+#else
+        p = new LogFile("log.txt");
+#endif
+    }
+    cout<<"Selected "; p->printInfo();
     
     // instantiate & initialize the HMPdetector components
 	Creator oneCreator(dF, dev);
-    Classifier oneClassifier(dF, dev, p);
+    Classifier oneClassifier(dF, dev, p, nT);
+    cout<<"Comparison threads: " <<oneClassifier.nbThreads <<endl;
     cout<<endl <<"Initialization phase of HMPdetector: DONE" <<endl;
     
     /*
@@ -192,11 +256,19 @@ int main(int argc, char* argv[])
 
     // available options (short-form)
 	//const char *short_options = "v:r:wbBctl:mh";
-    const char *short_options = "v:::mhE";
+    const char *short_options = "v:::s:::e:::p:::i:::S:::k:x:f:mhE";
 	// available options (long-form)
 	static struct option long_options[] = 
 	{
 		{"validate", required_argument, 0, 'v'},
+		{"streaming", required_argument, 0, 's'},
+		{"early", required_argument, 0, 'e'},
+		{"precision", required_argument, 0, 'p'},
+		{"incremental", required_argument, 0, 'i'},
+		{"server", required_argument, 0, 'S'},
+		{"kernel", required_argument, 0, 'k'},
+		{"convert", required_argument, 0, 'x'},
+		{"filter", required_argument, 0, 'f'},
 		//{"reason", required_argument, 0, 'r'},
 		//{"wearable", required_argument, 0, 'w'},
 		//{"Bracelet", required_argument, 0, 'B'},
@@ -239,9 +311,46 @@ int main(int argc, char* argv[])
 				break;
             */
 			case 'v':
+				if (argc > 5)
+					oneClassifier.hopSize = max(1, atoi(argv[5]));
+				oneClassifier.validateModel(argv[2], argv[3], atoi(argv[4]));
+				cout<<"results in: ./Results/" <<argv[3] <<"/" <<endl;
+				break;
+			case 's':
+				oneClassifier.compareStreaming(argv[2], argv[3], atoi(argv[4]));
+				cout<<"reports in: ./Results/" <<argv[3] <<"/streaming_*" <<endl;
+				break;
+			case 'e':
+				if (argc > 5)
+					oneClassifier.hopSize = max(1, atoi(argv[5]));
+				oneClassifier.earlyExit = true;
+				oneClassifier.resetCounters();
 				oneClassifier.validateModel(argv[2], argv[3], atoi(argv[4]));
+				oneClassifier.printCounters();
+				oneClassifier.earlyExit = false;
 				cout<<"results in: ./Results/" <<argv[3] <<"/" <<endl;
 				break;
+			case 'p':
+				oneClassifier.comparePrecision(argv[2], argv[3], atoi(argv[4]));
+				break;
+			case 'i':
+				oneClassifier.compareIncremental(argv[2], argv[3], atoi(argv[4]));
+				cout<<"reports in: ./Results/" <<argv[3] <<"/incremental_*" <<endl;
+				break;
+			case 'S':
+				oneClassifier.compareServer(argv[2], argv[3], atoi(argv[4]));
+				break;
+			case 'k':
+				oneClassifier.benchmarkPoint(atoi(argv[2]));
+				break;
+			case 'f':
+				oneClassifier.benchmarkFilter(atoi(argv[2]));
+				break;
+			case 'x':
+				ModelSet::convert(argv[2]);
+				cout<<"binary models in: ./Models/" <<argv[2] <<"/, dataset pack: ./Models/"
+					<<argv[2] <<DATASET_PACK_EXTENSION <<endl;
+				break;
             /*
 			case 't':
 				one_classifier.longTest(argv[2]);
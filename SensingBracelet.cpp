@@ -8,6 +8,7 @@
 
 #include <fstream>
 #include <limits>
+#include <sstream>
 
 #include "classifier.hpp"
 #include "SensingBracelet.hpp"
@@ -15,6 +16,12 @@
 
 #define pINF std::numeric_limits<int>::max();
 
+//! deadband of the interval tuples (possibility)
+static const double TUPLES_DEADBAND = 0.05;
+
+//! max silence of the interval tuples (ms)
+static const int TUPLES_HEARTBEAT_MS = 1000;
+
 using namespace boost::posix_time;
 
 //! constructor
@@ -85,28 +92,9 @@ void Interval::printStatus()
 //! constructor
 //! @param dF:	folder containing the modelling dataset
 SensingBracelet::SensingBracelet(string dF)
+	: tuples(TUPLES_DEADBAND, TUPLES_HEARTBEAT_MS)
 {
-	string one_HMPn;
-	float temp1;
-	float temp2;
-	float temp3;
-	Interval *one_interval;
-
-	datasetFolder = "./Models/" + dF + "/";
-	string fileName = datasetFolder + "Classifierconfig.txt";
-	//DEBUG: cout<<"config file: " <<fileName <<endl;
-	ifstream configFile(fileName.c_str());
-	configFile >>nbM;
-	//DEBUG: cout<<"nbM: " <<nbM <<endl;
-	for(int i=0; i< nbM; i++)
-	{
-		configFile>>one_HMPn >>temp1 >>temp2 >>temp3;
-		cout<<"Interval: " <<one_HMPn <<endl;
-		one_interval = new Interval(one_HMPn);
-		//DEBUG: one_interval->printStatus();
-		setI.push_back(*one_interval);
-	}
-	configFile.close();
+	buildSet(dF);
 }
 
 //! print set information
@@ -122,31 +110,23 @@ void SensingBracelet::printSetStatus()
 //! @return:		---
 void SensingBracelet::buildSet(string dF)
 {
-	string one_HMPn;
-	float temp1;
-	float temp2;
-	float temp3;
-	Interval *one_interval;
+	vector<ModelConfig> config;
 
 	// delete the existing intervals
 	setI.clear();
 
-	// load the new set of intervals
+	// load the new set of intervals (names from the dataset pack, if any:
+	// the mapping is kept, and shared with the classifier of the dataset)
 	datasetFolder = "./Models/" + dF + "/";
-	string fileName = datasetFolder + "Classifierconfig.txt";
-	//DEBUG: cout<<"config file: " <<fileName <<endl;
-	ifstream configFile(fileName.c_str());
-	configFile >>nbM;
+	pack = readDataset(dF, config);
+	nbM = config.size();
 	//DEBUG: cout<<"nbM: " <<nbM <<endl;
 	for(int i=0; i< nbM; i++)
 	{
-		configFile>>one_HMPn >>temp1 >>temp2 >>temp3;
-		cout<<"Interval: " <<one_HMPn <<endl;
-		one_interval = new Interval(one_HMPn);
-		//DEBUG: one_interval->printStatus();
-		setI.push_back(*one_interval);
+		cout<<"Interval: " <<config[i].name <<endl;
+		setI.push_back(Interval(config[i].name));
+		//DEBUG: setI[i].printStatus();
 	}
-	configFile.close();
 }
 
 //! publish the SensingBracelet tuples on PEIS
@@ -303,6 +283,7 @@ void SensingBracelet::simpleInterval(int& i,int& nS,float &p,float &pp)
 	        ntos<<p;
 	        string IntervalData;
 	        IntervalData = ntos.str();
+            tuples.emit(IntervalName, p);
             peiskmt_setStringTuple(IntervalName.c_str(), IntervalData.c_str());
 		}
 		// 1.2) already active - update ending time of the interval
@@ -311,7 +292,10 @@ void SensingBracelet::simpleInterval(int& i,int& nS,float &p,float &pp)
 			setI[i].end[0] = nS;
             if(p >= setI[i].possibility)
 			    setI[i].possibility = p;
+            // (published only if changed beyond the deadband, or heartbeat)
             string IntervalName = "Bracelet.HMP." + setI[i].HMPname;
+            if (!tuples.accept(IntervalName, p))
+                return;
             stringstream ntos;
 	        ntos<<p;
 	        string IntervalData;
@@ -328,6 +312,7 @@ void SensingBracelet::simpleInterval(int& i,int& nS,float &p,float &pp)
 
 		// update the info on PEIS
         string IntervalName = "Bracelet.HMP." + setI[i].HMPname;
+        tuples.emit(IntervalName, 0);
         peiskmt_setStringTuple(IntervalName.c_str(), "0");
 		
 		// close the interval
@@ -359,8 +344,22 @@ void SensingBracelet::offlineSensingBracelet(string path, string testFile)
 	string pFile = path + testFile;
 	ifstream pf(pFile.c_str());
 	cout <<"Reading possibilities in: " <<pFile <<endl;
-	while (!pf.eof())
+	vector<float> values;				// numbers of the current line
+	for (string line; std::getline(pf, line); )
 	{
+		values.clear();
+		istringstream numbers(line);
+		for (float v; numbers >>v; )
+			values.push_back(v);
+		if (values.empty())
+			continue;
+
+		// (results files start each line with the sample index, which is
+		// skipped; older files have the possibilities only)
+		size_t first = (values.size() > (size_t) nbM) ? 1 : 0;
+		if (values.size() - first < (size_t) nbM)
+			break;
+
 		// update the values of the past_possibilities
 		for(int i = 0; i < nbM; i++)
 			past_possibilities[i] = possibilities[i];
@@ -368,12 +367,10 @@ void SensingBracelet::offlineSensingBracelet(string path, string testFile)
 		// read the new possibilities
 		for(int i = 0; i < nbM; i++)
 		{
-			pf>>possibilities[i];
+			possibilities[i] = values[first + i];
 			//DEBUG: cout<<possibilities[i] <<" ";
 		}
 		//DEBUG: cout<<endl;
-		if (!pf)
-			break;
 
 		// extract/update the intervals of activation for each activity
 		for(int i = 0; i < nbM; i++)
@@ -412,8 +409,6 @@ void SensingBracelet::onlineSensingBracelet(char* port)
 	int gx, gy, gz;				// gyroscope current sample components
 	char dev;					// flag --> device type
 	string motion;				// flag --> level of motion at the wrist
-	vector<float> poss;			// models possibilities
-	vector<float> past_poss;	// models previous possibilities
 
 	string waste = " ";
 
@@ -421,16 +416,11 @@ void SensingBracelet::onlineSensingBracelet(char* port)
 	string dF = datasetFolder.substr(0,datasetFolder.length()-1);
 	dF = dF.substr(9);
 	Classifier hC(dF);
-	mat window = zeros<mat>(hC.window_size, 3);
-	mat gravity = zeros<mat>(hC.window_size, 3);
-	mat body = zeros<mat>(hC.window_size, 3);
-
-	// initialize the possibilities and past possibilities
-	for(int i = 0; i < nbM; i++)
-	{
-		poss.push_back(0);
-		past_poss.push_back(0);
-	}
+	Stream wearer(hC.currentSet(), hC.scoring == Classifier::INCREMENTAL);
+	hC.watch(1000);
+	DeadbandPublisher changes(hC.pub);
+	vector<float> &poss = wearer.possibilities;
+	vector<float> &past_poss = wearer.past_possibilities;
 	
 	// set up the serial communication (read-only)
 	SerialOptions options;
@@ -445,7 +435,7 @@ void SensingBracelet::onlineSensingBracelet(char* port)
 	serial.exceptions(ios::badbit | ios::failbit);
 
 	// extract known activities intervals from the stream of raw acceleration data
-	while(1)
+	while(peiskmt_isRunning())
 	{
 		try
 		{
@@ -456,18 +446,24 @@ void SensingBracelet::onlineSensingBracelet(char* port)
 			actsample <<ax <<ay <<az;
 			//DEBUG: cout<<"Acquired: " <<ax <<" " <<ay <<" " <<az <<" ";
 
-			// update the window of samples to be analyzed
-			hC.createWindow(actsample, window, hC.window_size, nSamples);
-			if (nSamples >= hC.window_size)
+			// update the window of samples and compute the models possibilities
+			if (hC.classifySample(actsample, wearer))
 			{
-				// analyze the window and compute the models possibilities
-				for(int i = 0; i < nbM; i++)
-					past_poss[i] = poss[i];
-				hC.analyzeWindow(window, gravity, body);
-				hC.compareAll(gravity, body, poss);
-
-				// publish the dynamic tuples
-				hC.publishDynamic(poss);
+				nSamples = wearer.nSamples;
+
+				// restart the intervals if the models have been reloaded
+				if (wearer.changed)
+				{
+					setI.clear();
+					nbM = wearer.models->nbM;
+					for (int i = 0; i < nbM; i++)
+						setI.push_back(Interval(wearer.models->set[i].HMPname));
+					tuples.reset();
+				}
+
+				// publish the dynamic tuples that changed (and the static ones
+				// after a reload)
+				hC.publishDynamic(wearer, &changes);
 
                 /**************************************************************
                 // ACCURATE A-POSTERIORI ACTIVITY ANALYSIS
@@ -488,4 +484,8 @@ void SensingBracelet::onlineSensingBracelet(char* port)
 			cerr<<"Timeout occurred"<<endl;
 		}
 	}
+
+	// publications saved by the deadbands during the session
+	cout<<"Recognition results. "; changes.policy.printCounters();
+	cout<<"Interval tuples. "; tuples.printCounters();
 }
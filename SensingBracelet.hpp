@@ -10,6 +10,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -19,6 +21,9 @@ extern "C"
 }
 #endif
 
+#include "deadband.hpp"
+#include "modelfile.hpp"
+
 using namespace std;
 
 #ifndef SENSINGBRACELET_HPP_
@@ -75,6 +80,10 @@ class SensingBracelet
 		string datasetFolder;		//!< folder containing the models
 		int nbM;					//!< number of considered models
 		vector<Interval> setI;		//!< set of open intervals
+		boost::shared_ptr<const DatasetPack> pack;	//!< dataset pack (shared
+													//!< with the classifier)
+		ChangePolicy tuples;		//!< change-driven publishing of the
+									//!< interval tuples (on-line)
 
 		//! constructor
 		SensingBracelet(string dF);
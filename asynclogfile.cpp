@@ -0,0 +1,246 @@
+//===============================================================================//
+// Name			: asynclogfile.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Interface for the log file (buffered, written in the background)
+//===============================================================================//
+
+#include <cerrno>
+#include <iostream>
+
+#include <boost/bind/bind.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asynclogfile.hpp"
+
+//! number of records that can be queued (fixed-size queues: at most 65534)
+//! @param[in] capacity	requested number of records
+//! @return				number of records of the queues
+static unsigned int queueCapacity(unsigned int capacity)
+{
+	if (capacity < 1)
+		return 1;
+	return (capacity > 65534) ? 65534 : capacity;
+}
+
+//! constructor
+//! (call to Publisher::Publisher constructor)
+//! @param[in] n		name of the publisher (log file)
+//! @param[in] fB		size of a batch (bytes): a full batch is written at once
+//! @param[in] fMs		max delay of a record (ms): partial batches are written
+//!						at least this often
+//! @param[in] capacity	number of records that can be queued (at most 65534)
+AsyncLogFile::AsyncLogFile(string n, size_t fB, int fMs, unsigned int capacity)
+	: Publisher(n), slots(queueCapacity(capacity)),
+	  freeSlots(queueCapacity(capacity)), filled(queueCapacity(capacity)),
+	  pendingBytes(0), pendingRecords(0), dropped(0), written(0)
+{
+	capacity = slots.size();
+	fd = open(name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd < 0)
+		cerr<<"Cannot open log file: " <<name <<endl;
+	flushBytes = fB;
+	flushMs = (fMs < 1) ? 1 : fMs;
+	flushRecords = (capacity > 1) ? capacity / 2 : 1;
+	requests = 0;
+	served = 0;
+	stop = false;
+
+	// preallocate the records (typical length: no allocation when publishing)
+	for (unsigned int i = 0; i < capacity; i++)
+	{
+		slots[i].text.reserve(128);
+		slots[i].values.reserve(32);
+		freeSlots.push(i);
+	}
+	writer = boost::thread(boost::bind(&AsyncLogFile::work, this));
+}
+
+//! get a free slot (the record is dropped if the queue is full)
+//! @param[out] &i	reference to the index of the slot
+//! @return			true if a slot is available
+bool AsyncLogFile::acquire(unsigned int &i)
+{
+	if (freeSlots.pop(i))
+		return true;
+	dropped++;
+	return false;
+}
+
+//! queue a filled slot
+//! (the writer is woken up as soon as the queued records make a batch)
+//! @param[in] i		index of the slot
+//! @param[in] size		expected size of the formatted record (bytes)
+void AsyncLogFile::release(unsigned int i, size_t size)
+{
+	// (counted before being queued: the writer may take it at once)
+	bool ready = batchReady();
+	pendingBytes += size;
+	pendingRecords++;
+	filled.push(i);
+	if (!ready && batchReady())
+	{
+		// (once per batch, under the lock: the writer is either before its
+		// check of the queued records or waiting, never in between)
+		boost::unique_lock<boost::mutex> guard(lock);
+		wake.notify_one();
+	}
+}
+
+//! publish information (queued, never blocks on the disk)
+//! @param[in] key     key of the information to be published
+//! @param[in] value   value of the information to be published
+void AsyncLogFile::publish(const string key, const string value)
+{
+	unsigned int i;
+	if (!acquire(i))
+		return;
+	Slot &record = slots[i];
+	record.results = false;
+	record.text.assign(key);
+	record.text.append(" ");
+	record.text.append(value);
+	record.text.append("\n");
+	release(i, record.text.size());
+}
+
+//! publish the dynamic information (queued as numbers)
+//! (same lines as the string adapter, formatted by the background writer)
+//! @param[in] &r      reference to the recognition results
+void AsyncLogFile::publishResults(const ResultRecord &r)
+{
+	unsigned int i;
+	if (!acquire(i))
+		return;
+	Slot &record = slots[i];
+	record.results = true;
+	record.values.assign(r.possibilities, r.possibilities + r.nbM);
+	if (r.best == -1)
+		record.text.assign("NONE");
+	else
+		record.text.assign(r.names[r.best]);
+	record.other = r.other();
+	record.entropy = r.entropy();
+	release(i, 64 + 12 * r.nbM);
+}
+
+//! move the queued records into a batch (formatting the recognition results)
+//! @param[in,out] &batch	reference to the batch
+void AsyncLogFile::collect(string &batch)
+{
+	unsigned int i;
+	while (batch.size() < flushBytes && filled.pop(i))
+	{
+		Slot &record = slots[i];
+		if (record.results)
+		{
+			batch.append("possibilities ");
+			appendPossibilities(batch, &record.values[0], record.values.size());
+			batch.append("\nhighest ").append(record.text);
+			batch.append("\nother ");
+			appendNumber(batch, record.other);
+			batch.append("\nentropy ");
+			appendNumber(batch, record.entropy);
+			batch.append("\n");
+			pendingBytes -= 64 + 12 * record.values.size();
+		}
+		else
+		{
+			batch.append(record.text);
+			pendingBytes -= record.text.size();
+		}
+		pendingRecords--;
+		freeSlots.push(i);
+		written++;
+	}
+}
+
+//! write a batch on the log file (one system call per batch)
+//! @param[in,out] &batch	reference to the batch (emptied)
+void AsyncLogFile::writeBatch(string &batch)
+{
+	size_t done = 0;
+	while (fd >= 0 && done < batch.size())
+	{
+		ssize_t n = write(fd, batch.data() + done, batch.size() - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+		{
+			cerr<<"Cannot write log file: " <<name <<endl;
+			break;
+		}
+		done += n;
+	}
+	batch.clear();
+}
+
+//! main loop of the background writer
+//! (a batch is written when full, or when the oldest record is flushMs old)
+void AsyncLogFile::work()
+{
+	string batch;
+	batch.reserve(flushBytes + 1024);
+	while (true)
+	{
+		bool stopping;
+		unsigned long request;
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			if (!stop && requests == served && !batchReady())
+				wake.timed_wait(guard, boost::posix_time::milliseconds(flushMs));
+			stopping = stop;
+			request = requests;
+		}
+
+		// write full batches, then what is left (the max delay has elapsed)
+		collect(batch);
+		while (batch.size() >= flushBytes)
+		{
+			writeBatch(batch);
+			collect(batch);
+		}
+		if (!batch.empty())
+			writeBatch(batch);
+
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			served = request;
+		}
+		flushed.notify_all();
+		if (stopping)
+			return;
+	}
+}
+
+//! write all the queued records and wait for their completion
+//! (to be called at shutdown or at checkpoints, not on the classification path)
+void AsyncLogFile::flush()
+{
+	boost::unique_lock<boost::mutex> guard(lock);
+	unsigned long request = requests + 1;
+	requests = request;
+	wake.notify_one();
+	while (served < request)
+		flushed.wait(guard);
+}
+
+//! destructor (writes the queued records, stops the writer)
+AsyncLogFile::~AsyncLogFile()
+{
+	{
+		boost::unique_lock<boost::mutex> guard(lock);
+		stop = true;
+		requests = requests + 1;
+	}
+	wake.notify_one();
+	writer.join();
+	if (fd >= 0)
+		close(fd);
+	if (dropped > 0)
+		cerr<<"Log file " <<name <<": " <<dropped <<" records dropped" <<endl;
+	//DEBUG:cout<<endl <<"Destroying AsyncLogFile object" <<endl;
+}
@@ -0,0 +1,112 @@
+//===============================================================================//
+// Name			: asynclogfile.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Interface for the log file (buffered, written in the background)
+//===============================================================================//
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/thread.hpp>
+
+#include "publisher.hpp"
+
+using namespace std;
+
+#ifndef ASYNCLOGFILE_HPP_
+#define ASYNCLOGFILE_HPP_
+
+//! derivate class "AsyncLogFile", interface for the log file
+//! (the records are queued without locks by the publishing threads and
+//! written in batches by a background thread, on one open descriptor:
+//! publishing never waits for the disk; if the queue is full the record
+//! is dropped and counted; recognition results are queued as numbers and
+//! formatted by the background thread)
+class AsyncLogFile: public Publisher
+{
+	private:
+		//! record "Slot", one queued record (preallocated, reused)
+		struct Slot
+		{
+			bool results;			//!< flag --> recognition results (numbers)
+			string text;			//!< "key value" line, or name of the highest
+			vector<float> values;	//!< possibilities of the models (results)
+			float other;			//!< possibility of no model (results)
+			float entropy;			//!< margin of the highest (results)
+		};
+
+		//! queue of slot indexes (fixed size: pushing never allocates)
+		typedef boost::lockfree::queue<unsigned int,
+				boost::lockfree::fixed_sized<true> > SlotQueue;
+
+		int fd;								//!< descriptor of the log file
+		vector<Slot> slots;					//!< preallocated records
+		SlotQueue freeSlots;				//!< slots to be filled
+		SlotQueue filled;					//!< slots to be written
+		size_t flushBytes;					//!< size of a batch (bytes)
+		int flushMs;						//!< max delay of a record (ms)
+		unsigned int flushRecords;			//!< queued records waking the writer
+		boost::atomic<size_t> pendingBytes;			//!< size of the queued records
+		boost::atomic<unsigned int> pendingRecords;	//!< number of queued records
+		boost::thread writer;				//!< background writer
+		boost::mutex lock;					//!< lock of the writer status
+		boost::condition_variable wake;		//!< signals a flush request (or stop)
+		boost::condition_variable flushed;	//!< signals a completed flush
+		unsigned long requests;				//!< number of flush requests
+		unsigned long served;				//!< number of served flush requests
+		bool stop;							//!< flag --> terminate the writer
+
+		//! copy constructor (not allowed: the descriptor is owned by the object)
+		AsyncLogFile(const AsyncLogFile &other);
+
+		//! assignment operator (not allowed: the descriptor is owned by the object)
+		AsyncLogFile& operator=(const AsyncLogFile &other);
+
+		//! main loop of the background writer
+		void work();
+
+		//! check whether the queued records make a batch
+		//! @return		true if a batch (or half of the queue) is ready
+		bool batchReady() const
+		{
+			return (pendingBytes >= flushBytes || pendingRecords >= flushRecords);
+		}
+
+		//! get a free slot
+		bool acquire(unsigned int &i);
+
+		//! queue a filled slot
+		void release(unsigned int i, size_t size);
+
+		//! move the queued records into a batch
+		void collect(string &batch);
+
+		//! write a batch on the log file
+		void writeBatch(string &batch);
+
+	public:
+		boost::atomic<unsigned long> dropped;	//!< records dropped (queue full)
+		boost::atomic<unsigned long> written;	//!< records written on the file
+
+		//! constructor
+		AsyncLogFile(string n, size_t fB = 64 * 1024, int fMs = 200,
+					 unsigned int capacity = 4096);
+
+		//! publish information (queued, never blocks on the disk)
+		void publish(const string key, const string value);
+
+		//! publish the dynamic information (queued as numbers)
+		void publishResults(const ResultRecord &r);
+
+		//! write all the queued records and wait for their completion
+		void flush();
+
+		//! destructor (writes the queued records, stops the writer)
+		~AsyncLogFile();
+};
+
+#endif
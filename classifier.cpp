@@ -6,14 +6,31 @@
 // Description	: Human Motion Primitives classifier module (on-line / off-line)
 //===============================================================================//
 
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
+
+#include <boost/bind/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <sys/stat.h>
 
 #include "classifier.hpp"
+#include "scorer.hpp"
+#include "server.hpp"
+#include "triaxial.hpp"
 #include "libs/SerialStream.h"
 
 using namespace arma;
 using namespace boost::posix_time;
 
+//! prefix of the results files (each precision of the pipeline keeps its own)
+#ifdef HMP_FLOAT32
+static const string RESULTS_PREFIX = "res32_";
+#else
+static const string RESULTS_PREFIX = "res_";
+#endif
+
 //! constructor with variables initialization
 //! @param[in] HMPn	name of the motion primitive (within the dataset)
 //! @param[in] gW	weight of gravity feature for classification
@@ -21,27 +38,11 @@ using namespace boost::posix_time;
 //! @param[in] th	max distance for possible motion occurrence
 DYmodel::DYmodel(string HMPn, float gW, float bW, float th)
 {
-	// initialize the class variables
-	cout<<"Loading model: " <<HMPn <<"...";
-	HMPname = HMPn;
-	gravityWeight = gW;
-	bodyWeight = bW;
-	threshold = th;
-
-	// load the model (initialization of gP, gS, bP, bS)
-	bP = loadMu(HMPname, "Body");		//DEBUG: cout<<"MuBody-";
-	bS = loadSigma(HMPname, "Body");	//DEBUG: cout<<"SigmaBody-";
-	gP = loadMu(HMPname, "Gravity");	//DEBUG: cout<<"MuGravity-";
-	gS = loadSigma(HMPname, "Gravity");	//DEBUG: cout<<"SigmaGravity-";
-
-	// compute the size of the model
-	size = gP.n_cols;
-
-	cout<<"DONE"<<endl;
+	build(HMPn, gW, bW, th);
 }
 
 //! print model information
-void DYmodel::printInfo()
+void DYmodel::printInfo() const
 {
 	cout<<"DYmodel object information:" <<endl;
 	cout<<"HMPname = " <<HMPname <<endl;
@@ -51,73 +52,38 @@ void DYmodel::printInfo()
 	cout<<"size = " <<size <<endl;
 }
 
-//!\todo replace C-style reading from file with fstream 
-
 //! load the expected points (Mu) of one feature
 //! @param[in] HMPname		name of the model (within the dataset)
 //! @param[in] component	name of the feature
-//! @return     			matrix of the expected points of the feature
+//! @return     			matrix of the expected points of the feature (3xsize)
 mat DYmodel::loadMu(string HMPname, string component)
 {
-	int row;
-	int col;
-
-	string fileName = HMPname + "Mu" + component + ".txt";
-	FILE *pf = fopen(fileName.c_str(), "r");
-	fscanf(pf, "%d,%d\n", &col, &row);
-	mat mod = zeros<mat>(row, col);
-	for (int r = 0; r < row; r++)
-	{
-		int c;
-		float fr;
-		for (c = 0; c < col - 1; c++)
-		{
-			fscanf(pf, "%f,", &fr);
-			mod(r, c) = fr;
-		}
-		fscanf(pf, "%f\n", &fr);
-		mod(r, c) = fr;
-	}
-	mod = mod.t();
-	fclose(pf);
-
-	return mod;
+	return readMuText(HMPname + "Mu" + component + ".txt");
 }
 
-//!\todo replace C-style reading from file with fstream 
-
 //! load the expected variances (Sigma) of one feature
 //! @param[in] HMPname		name of the model (within the dataset)
 //! @param[in] component	name of the feature
 //! @return			        matrix of the expected variances of the feature
 cube DYmodel::loadSigma(string HMPname, string component)
 {
-    int row;
-	int col;
-	int slice;
+	return readSigmaText(HMPname + "Sigma" + component + ".txt");
+}
 
-    string fileName = HMPname + "Sigma" + component + ".txt";
-	FILE *pf = fopen(fileName.c_str(), "r");
-	fscanf(pf, "%d,%d,%d\n", &row, &col, &slice);
-	cube mod = zeros<cube>(row, col, slice);
-	for (int s = 0; s < slice; s++)
+//! compute the inverse of each covariance matrix of one feature
+//! (closed-form 3x3 symmetric inverse: no temporary matrix per point)
+//! @param[in] &sigma	reference to the set of covariance matrices
+//! @return			    set of the inverse covariance matrices
+cube DYmodel::invertSigma(cube &sigma)
+{
+	cube inv = zeros<cube>(sigma.n_rows, sigma.n_cols, sigma.n_slices);
+	for (unsigned int s = 0; s < sigma.n_slices; s++)
 	{
-		for (int r = 0; r < row; r++)
-		{
-			int c;
-			float fr;
-			for (c = 0; c < col - 1; c++)
-			{
-				fscanf(pf, "%f,", &fr);
-				mod(r, c, s) = fr;
-			}
-			fscanf(pf, "%f\n", &fr);
-			mod(r, c, s) = fr;
-		}
+		SymMat3<double> S = SymMat3<double>::fromFull(sigma.slice_memptr(s));
+		S.inverse().storeFull(inv.slice_memptr(s));
 	}
-	fclose(pf);
 
-	return mod;
+	return inv;
 }
 
 //! set all the model variables and load the model
@@ -128,58 +94,253 @@ cube DYmodel::loadSigma(string HMPname, string component)
 void DYmodel::build(string HMPn, float gW, float bW, float th)
 {
 	// initialize the class variables
-	cout<<"Loading model: " <<HMPn <<"...";
+	ptime start = microsec_clock::local_time();
 	HMPname = HMPn;
 	gravityWeight = gW;
 	bodyWeight = bW;
 	threshold = th;
 
-	// load the model (initialization of gP, gS, bP, bS)
+	// load the model (initialization of gP, gS, bP, bS and of the kernels):
+	// binary model file if available and not older than the text files
+	// (a retrained model is never shadowed), text files otherwise
+	string binaryName = HMPname + MODEL_FILE_EXTENSION;
+	uint64_t textTime = modelTextTime(HMPname);
+	if (textTime > 0 && fileTime(binaryName) < textTime)
+		loadText();
+	else if (!loadBinary(binaryName))
+		loadText();
+
+	loadTime = (microsec_clock::local_time() - start).total_microseconds() / 1000.0;
+}
+
+//! set all the model variables and use the model of a dataset pack
+//! (the distance kernels use the mapped arrays in place)
+//! @param[in] pack	dataset pack (shared mapping)
+//! @param[in] i	index of the model within the dataset pack
+void DYmodel::build(boost::shared_ptr<const DatasetPack> pack, int i)
+{
+	const DatasetPackEntry &e = pack->entry(i);
+	ptime start = microsec_clock::local_time();
+	HMPname = e.name;
+	gravityWeight = e.gravityWeight;
+	bodyWeight = e.bodyWeight;
+	threshold = e.threshold;
+
+	size = e.size;
+	const double* blocks[NB_MODEL_BLOCKS];
+	for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+		blocks[b] = pack->block(i, (ModelBlock) b);
+	useBlocks(blocks);
+	mapping = pack;
+
+	loadTime = (microsec_clock::local_time() - start).total_microseconds() / 1000.0;
+}
+
+//! load the model from its text files (Mu and Sigma of both features)
+void DYmodel::loadText()
+{
 	bP = loadMu(HMPname, "Body");		//DEBUG: cout<<"MuBody-";
 	bS = loadSigma(HMPname, "Body");	//DEBUG: cout<<"SigmaBody-";
 	gP = loadMu(HMPname, "Gravity");	//DEBUG: cout<<"MuGravity-";
 	gS = loadSigma(HMPname, "Gravity");	//DEBUG: cout<<"SigmaGravity-";
 
+	// the four files must describe the same number of points
+	// (each file is checked on its own when read)
+	if (gS.n_slices != gP.n_cols || bP.n_cols != gP.n_cols
+		|| bS.n_slices != gP.n_cols)
+		throw runtime_error("malformed model files: " + HMPname);
+
+	// precompute the inverse covariance matrices (used for classification)
+	bSi = invertSigma(bS);
+	gSi = invertSigma(gS);
+	bK.build(bP, bSi);
+	gK.build(gP, gSi);
+
 	// compute the size of the model
 	size = gP.n_cols;
+	for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+		mapped[b] = NULL;
+	mapping.reset();
+}
 
+//! load the model from its binary file (mapped in memory)
+//! (the distance kernels use the mapped arrays in place)
+//! @param[in] fileName	name of the binary model file
+//! @return				true if the binary model has been loaded
+bool DYmodel::loadBinary(string fileName)
+{
+	boost::shared_ptr<ModelFile> binary(new ModelFile());
+	if (!binary->open(fileName))
+		return false;
+
+	size = binary->size();
+	const double* blocks[NB_MODEL_BLOCKS];
+	for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+		blocks[b] = binary->block((ModelBlock) b);
+	useBlocks(blocks);
+	mapping = binary;
+
+	return true;
+}
+
+//! use the mapped blocks of the model (binary model file or dataset pack)
+//! (nothing is copied: Mu and Sigma are read in place through block, and the
+//! kernels are attached to the mapping)
+//! @param[in] *blocks	pointers to the blocks of the model (size points)
+void DYmodel::useBlocks(const double* const* blocks)
+{
+	for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+		mapped[b] = blocks[b];
+	gP.reset();
+	gS.reset();
+	gSi.reset();
+	bP.reset();
+	bS.reset();
+	bSi.reset();
+	gK.attach(blocks[GRAVITY_KERNEL], size);
+	bK.attach(blocks[BODY_KERNEL], size);
+}
+
+//! get one block of the model
+//! @param[in] b	block of the model (points or matrices of one feature)
+//! @return			pointer to the first element of the block (mapped memory,
+//!					or arrays loaded from the text files; NULL: kernel block
+//!					of a text model)
+const double* DYmodel::block(ModelBlock b) const
+{
+	if (mapped[b] != NULL)
+		return mapped[b];
+	switch (b)
+	{
+		case GRAVITY_MU:
+			return gP.memptr();
+		case GRAVITY_SIGMA:
+			return gS.memptr();
+		case GRAVITY_INVERSE:
+			return gSi.memptr();
+		case BODY_MU:
+			return bP.memptr();
+		case BODY_SIGMA:
+			return bS.memptr();
+		case BODY_INVERSE:
+			return bSi.memptr();
+		default:
+			return NULL;
+	}
+}
+
+//! write the binary file of the model
+//! @param[in] fileName	name of the binary model file
+void DYmodel::save(string fileName) const
+{
+	ModelFile::write(fileName, mu(GRAVITY_MU), sigma(GRAVITY_SIGMA),
+					 sigma(GRAVITY_INVERSE), mu(BODY_MU), sigma(BODY_SIGMA),
+					 sigma(BODY_INVERSE));
+}
+
+//! convert the text files of a model into its binary file
+//! @param[in] HMPn	name of the motion primitive (with the dataset folder)
+void DYmodel::convert(string HMPn)
+{
+	cout<<"Converting model: " <<HMPn <<"...";
+	HMPname = HMPn;
+	loadText();
+	save(HMPname + MODEL_FILE_EXTENSION);
 	cout<<"DONE"<<endl;
 }
 
-//! constructor
+//! class "LoadJob", loading of the models of a set on a pool of threads
+//! (each model is built in place, in its declared position within the set)
+class LoadJob : public WorkerPool::Job
+{
+	public:
+		ModelSet* owner;					//!< set of models being loaded
+		const vector<ModelConfig>* config;	//!< parameters of the models
+		vector<string> errors;				//!< loading errors (empty: success)
+
+		//! constructor
+		//! @param[in] *s	pointer to the set of models (already sized)
+		//! @param[in] &c	reference to the parameters of the models
+		LoadJob(ModelSet* s, const vector<ModelConfig> &c)
+		{
+			owner = s;
+			config = &c;
+			errors.resize(c.size());
+		}
+
+		//! load one part of the models
+		//! @param[in] part		index of the part
+		//! @param[in] nbParts	number of parts
+		void run(int part, int nbParts)
+		{
+			for (int i = part; i < owner->nbM; i += nbParts)
+			{
+				const ModelConfig &c = (*config)[i];
+				DYmodel &one_model = owner->set[i];
+				try
+				{
+					if (owner->pack)
+						one_model.build(owner->pack, i);
+					else
+					{
+						one_model.build(owner->datasetFolder + c.name, c.gravityWeight,
+										c.bodyWeight, c.threshold);
+						one_model.HMPname = c.name;
+					}
+				}
+				catch (std::exception &e)
+				{
+					errors[i] = e.what();
+				}
+			}
+		}
+};
+
+//! constructor (loads the models)
+//! (dataset pack if available, one file or set of files per model otherwise;
+//! the models are loaded concurrently, each one in its declared position)
 //! @param[in] dF	folder containing the modelling dataset
-//! @param[in] dev  driver for the device used for the dataset collection
-//! @param[in] p    interface for the publishing middleware
-Classifier::Classifier(string dF, Device* dev, Publisher* p)
+//! @param[in] nT	max number of loading threads (0: one per core)
+ModelSet::ModelSet(string dF, int nT)
 {
-	string one_HMPn;
-	float one_gW;
-	float one_bW;
-	float one_th;
-	DYmodel *one_model;
+	vector<ModelConfig> config;
 
+	ptime start = microsec_clock::local_time();
+	datasetName = dF;
 	datasetFolder = "./Models/" + dF + "/";
-    driver = dev;
-    //DEBUG:driver->printInfo();
-    pub = p;
-    pub->printInfo();
-	string fileName = datasetFolder + "Classifierconfig.txt";
-	//DEBUG:cout<<"config file: " <<fileName <<endl;
-	ifstream configFile(fileName.c_str());
-	configFile >>nbM;
+	pack = readDataset(dF, config);
+	filter = readFilterConfig(datasetFolder + "Filterconfig.txt");
+	nbM = config.size();
 	//DEBUG:cout<<"nbM: " <<nbM <<endl;
+
+	// load the models on a bounded pool of threads (released once done)
+	if (nT < 1)
+		nT = boost::thread::hardware_concurrency();
+	nT = max(1, min(nT, nbM));
+	set.resize(nbM);
+	LoadJob job(this, config);
+	{
+		WorkerPool loaders(nT);
+		loaders.run(job);
+	}
 	for(int i=0; i< nbM; i++)
 	{
-		configFile>>one_HMPn >>one_gW >>one_bW >>one_th;
-		one_HMPn = datasetFolder + one_HMPn;
-		//DEBUG:cout<<"DYmodel: " <<one_HMPn <<endl;
-		one_model = new DYmodel(one_HMPn, one_gW, one_bW, one_th);
-		//DEBUG:one_model->printInfo();
-		set.push_back(*one_model);
+		if (!job.errors[i].empty())
+			throw runtime_error(job.errors[i]);
+		cout<<"Loaded model: " <<set[i].HMPname <<" (" <<set[i].size <<" points, "
+			<<(pack ? "pack" : (set[i].mapping ? "binary" : "text")) <<") in "
+			<<set[i].loadTime <<" ms" <<endl;
 	}
-	configFile.close();
+	names.resize(nbM);
+	for(int i=0; i< nbM; i++)
+		names[i] = set[i].HMPname;
+	cout<<nbM <<" models loaded by " <<nT <<" threads in "
+		<<(microsec_clock::local_time() - start).total_microseconds() / 1000.0
+		<<" ms" <<endl;
 
 	// compute the size of the window
+    cout<<"Distance kernel: " <<MahalanobisKernel::instructionSet()
+		<<" (" <<8 * sizeof(real_t) <<"-bit)" <<endl;
     cout<<"HMP models loaded. Defining window size as: ";
 	int temp_ws = set[0].size;
 	for(int i=1; i< nbM; i++)
@@ -189,138 +350,624 @@ Classifier::Classifier(string dF, Device* dev, Publisher* p)
 	}
 	window_size = temp_ws;
     cout<<window_size <<endl;
+}
+
+//! print set information
+void ModelSet::printInfo() const
+{
+	for(int i=0; i<nbM; i++)
+		set[i].printInfo();
+}
+
+//! convert the text files of a dataset into binary files
+//! (one binary file per model, and the dataset pack with all the models)
+//! @param[in] dF	folder containing the modelling dataset
+void ModelSet::convert(string dF)
+{
+	vector<ModelConfig> config;
+	vector<DatasetPackEntry> toc;
+	vector<double> blocks;
+
+	string folder = "./Models/" + dF + "/";
+	readClassifierConfig(folder + "Classifierconfig.txt", config);
+	toc.resize(config.size());
+	for(unsigned int i=0; i< config.size(); i++)
+	{
+		if (config[i].name.size() >= sizeof(toc[i].name))
+			throw runtime_error("model name too long: " + config[i].name);
+		DYmodel one_model;
+		one_model.convert(folder + config[i].name);
+
+		// add the model to the dataset pack
+		DatasetPackEntry &e = toc[i];
+		memset(&e, 0, sizeof(e));
+		strcpy(e.name, config[i].name.c_str());
+		e.gravityWeight = config[i].gravityWeight;
+		e.bodyWeight = config[i].bodyWeight;
+		e.threshold = config[i].threshold;
+		e.size = one_model.size;
+		e.offset = blocks.size();
+		ModelFile::serialize(one_model.mu(GRAVITY_MU), one_model.sigma(GRAVITY_SIGMA),
+							 one_model.sigma(GRAVITY_INVERSE), one_model.mu(BODY_MU),
+							 one_model.sigma(BODY_SIGMA), one_model.sigma(BODY_INVERSE),
+							 blocks);
+	}
+	DatasetPack::write("./Models/" + dF + DATASET_PACK_EXTENSION, toc, blocks);
+}
+
+//! constructor
+//! @param[in] m			shared set of models to be recognized
+//! @param[in] incremental	flag --> allocate the running sums (INCREMENTAL scoring)
+Stream::Stream(boost::shared_ptr<const ModelSet> m, bool incremental)
+	: models(m), window(m->window_size), pre(m->window_size, m->filter),
+	  lowPass(m->filter)
+{
+	changed = false;
+	nSamples = 0;
+	scorer = NULL;
+	if (incremental)
+		scorer = new IncrementalScorer(models->set, models->window_size);
+	gravity = zeros<rmat>(3, models->window_size);
+	body = zeros<rmat>(3, models->window_size);
+	possibilities.assign(models->nbM, 0);
+	past_possibilities.assign(models->nbM, 0);
+}
+
+//! move the state to a new set of models
+//! (raw samples, filters state and features are kept, as many as fit in the
+//! new window; the running sums are rebuilt from the kept features, so that
+//! the stream goes on without waiting for a new window to fill)
+//! @param[in] m	shared set of models to be recognized
+void Stream::rebind(boost::shared_ptr<const ModelSet> m)
+{
+	int ws = m->window_size;
+	window.resizeKeep(ws);
+	pre.resizeWindow(ws);
+	if (!(m->filter == lowPass.config()))
+	{
+		// (new sampling rate or cutoff: the causal filter starts again)
+		lowPass.configure(m->filter);
+		pre.configure(m->filter);
+	}
+	gravity = zeros<rmat>(3, ws);
+	body = zeros<rmat>(3, ws);
+	if (scorer != NULL)
+	{
+		delete scorer;
+		scorer = new IncrementalScorer(m->set, ws);
+		for (int k = 0; k < pre.gravity.stored(); k++)
+			scorer->push(pre.gravity.sample(k), pre.body.sample(k));
+	}
+	if (m->nbM != models->nbM)
+	{
+		possibilities.assign(m->nbM, 0);
+		past_possibilities.assign(m->nbM, 0);
+	}
+	models = m;
+	changed = true;
+}
+
+//! destructor
+Stream::~Stream()
+{
+	delete scorer;
+	//DEBUG:cout<<endl <<"Destroying Stream object" <<endl;
+}
+
+//! constructor
+//! @param[in] dF	folder containing the modelling dataset
+//! @param[in] dev  driver for the device used for the dataset collection
+//! @param[in] p    interface for the publishing middleware
+//! @param[in] nT   number of threads used to compare the models (1: serial)
+Classifier::Classifier(string dF, Device* dev, Publisher* p, int nT)
+{
+	init(dev, p, nT);
+	adoptSet(boost::shared_ptr<const ModelSet>(new ModelSet(dF)));
 
 	// publish the static information (number & names of models)
 	publishStatic();
 }
 
+//! constructor with a shared set of models
+//! @param[in] m	shared set of models (not copied)
+//! @param[in] dev  driver for the device used for the dataset collection
+//! @param[in] p    interface for the publishing middleware
+//! @param[in] nT   number of threads used to compare the models (1: serial)
+Classifier::Classifier(boost::shared_ptr<const ModelSet> m, Device* dev,
+					   Publisher* p, int nT)
+{
+	init(dev, p, nT);
+	swapSet(m);
+
+	// publish the static information (number & names of models)
+	publishStatic();
+}
+
+//! initialize the classifier variables (models excluded)
+//! @param[in] dev  driver for the device used for the dataset collection
+//! @param[in] p    interface for the publishing middleware
+//! @param[in] nT   number of threads used to compare the models (1: serial)
+void Classifier::init(Device* dev, Publisher* p, int nT)
+{
+    driver = dev;
+    //DEBUG:driver->printInfo();
+    pub = p;
+    pub->printInfo();
+	streaming = false;
+	scoring = BATCH;
+	nbThreads = (nT < 1) ? 1 : nT;
+	hopSize = 1;
+	earlyExit = false;
+	resetCounters();
+	pool = NULL;
+	if (nbThreads > 1)
+		pool = new WorkerPool(nbThreads);
+	reloader = NULL;
+	reloadRequested = false;
+	stopReload = false;
+	watchPeriod = 0;
+}
+
+//! replace the set of models
+//! (atomic: the samples being classified keep the set they started with, and
+//! each stream moves to the new set at its next sample; safe from the
+//! reloader thread: nothing else is written, the per-window paths take the
+//! sizes from their own snapshot of the set)
+//! @param[in] m	shared set of models
+void Classifier::swapSet(boost::shared_ptr<const ModelSet> m)
+{
+	boost::atomic_store(&models, m);
+}
+
+//! replace the set of models and describe it
+//! (nbM, window_size and datasetFolder are plain fields: to be called by the
+//! classifying thread only, never by the reloader)
+//! @param[in] m	shared set of models
+void Classifier::adoptSet(boost::shared_ptr<const ModelSet> m)
+{
+	swapSet(m);
+	datasetFolder = m->datasetFolder;
+	nbM = m->nbM;
+	window_size = m->window_size;
+
+	// (partial sums of the threads sized once per set, not once per window)
+	if (pool != NULL)
+	{
+		boost::unique_lock<boost::mutex> guard(partialLock);
+		if (partial.size() < (unsigned int) (2 * nbThreads * nbM))
+			partial.resize(2 * nbThreads * nbM);
+	}
+}
+
+//! load the current dataset again and swap the new set in
+//! (the new set is built aside: classification goes on with the old one,
+//! which is kept if loading fails)
+//! @return		true if the new set has been swapped in
+bool Classifier::reload()
+{
+	string dF = currentSet()->datasetName;
+	try
+	{
+		swapSet(boost::shared_ptr<const ModelSet>(new ModelSet(dF)));
+	}
+	catch (std::exception &e)
+	{
+		cerr<<"Reload of " <<dF <<" failed (models unchanged): " <<e.what() <<endl;
+		return false;
+	}
+	cout<<"Reloaded dataset: " <<dF <<endl;
+
+	return true;
+}
+
+//! ask for a reload in the background (the call does not wait)
+void Classifier::requestReload()
+{
+	{
+		boost::unique_lock<boost::mutex> guard(reloadLock);
+		reloadRequested = true;
+	}
+	startReloader();
+	reloadWake.notify_one();
+}
+
+//! check the dataset files periodically and reload them when changed
+//! @param[in] periodMs		period of the check (ms, 0: stop checking)
+void Classifier::watch(int periodMs)
+{
+	{
+		boost::unique_lock<boost::mutex> guard(reloadLock);
+		watchPeriod = (periodMs > 0) ? periodMs : 0;
+	}
+	startReloader();
+	reloadWake.notify_one();
+}
+
+//! start the background reloads (if not running yet)
+void Classifier::startReloader()
+{
+	boost::unique_lock<boost::mutex> guard(reloadLock);
+	if (reloader == NULL)
+		reloader = new boost::thread(boost::bind(&Classifier::reloadLoop, this));
+}
+
+//! stop and join the background reloads
+void Classifier::stopReloader()
+{
+	{
+		boost::unique_lock<boost::mutex> guard(reloadLock);
+		stopReload = true;
+	}
+	reloadWake.notify_one();
+	if (reloader != NULL)
+	{
+		reloader->join();
+		delete reloader;
+		reloader = NULL;
+	}
+}
+
+//! get the signature of the files of a dataset
+//! (folder, configuration and dataset pack: the binary files are renamed into
+//! place, which updates the folder, so any new file changes the signature)
+//! @param[in] dF	name of the dataset
+//! @return			signature (sizes, inodes and modification times)
+static string datasetSignature(string dF)
+{
+	string names[4] = {"./Models/" + dF + "/",
+					   "./Models/" + dF + "/Classifierconfig.txt",
+					   "./Models/" + dF + "/Filterconfig.txt",
+					   "./Models/" + dF + DATASET_PACK_EXTENSION};
+	stringstream signature;
+	for (int i = 0; i < 4; i++)
+	{
+		struct stat info;
+		if (stat(names[i].c_str(), &info) == 0)
+			signature<<info.st_ino <<":" <<info.st_size <<":" <<info.st_mtime <<" ";
+		else
+			signature<<"- ";
+	}
+
+	return signature.str();
+}
+
+//! main loop of the background reloads
+//! (explicit requests are served at once; changes of the dataset files are
+//! served once the files have been stable for a whole period)
+void Classifier::reloadLoop()
+{
+	string loaded = datasetSignature(currentSet()->datasetName);
+	string seen = loaded;
+	while (true)
+	{
+		bool requested;
+		{
+			boost::unique_lock<boost::mutex> guard(reloadLock);
+			if (!stopReload && !reloadRequested)
+			{
+				if (watchPeriod > 0)
+					reloadWake.timed_wait(guard, milliseconds(watchPeriod));
+				else
+					reloadWake.wait(guard);
+			}
+			if (stopReload)
+				return;
+			requested = reloadRequested;
+			reloadRequested = false;
+		}
+
+		string now = datasetSignature(currentSet()->datasetName);
+		bool stable = (now == seen);
+		seen = now;
+		if (requested || (stable && now != loaded))
+		{
+			reload();
+			loaded = now;
+		}
+	}
+}
+
 //! print set information
 void Classifier::printSetInfo()
 {
-	for(int i=0; i<nbM; i++)
-		set[i].printInfo();
+	currentSet()->printInfo();
 }
 
 //! create a window of samples
 //! @param[in] &one_sample	    reference to the sample to be added to the window
-//! @param[in,out] &window		reference to the window
-//! @param[in] &N			    reference to the size of the window
+//! @param[in,out] &window		reference to the window (circular buffer)
 //! @param[in,out] &numWritten  reference to the number of samples in the window
-void Classifier::createWindow(mat &one_sample, mat &window, int &N, int &numWritten)
+void Classifier::createWindow(mat &one_sample, SampleBuffer &window, int &numWritten)
 {
-	// update the window content
-	if (numWritten < N)
-	{
-		window.row(numWritten) = one_sample.row(0);
-		numWritten = numWritten + 1;
-	}
-	else
-	{
-		for (int i = 0; i < N - 1; i++)
-			window.row(i) = window.row(i + 1);
-		window.row(N - 1) = one_sample;
-		numWritten = numWritten + 1;
-	}
+	// update the window content (the oldest sample is overwritten)
+	window.push(one_sample);
+	numWritten = numWritten + 1;
 }
 
 //! get gravity and body acc. components of the window
-//! @param[in] &window		reference to the window
+//! (uses the filter of the classifier: to be called by one thread at a time)
+//! @param[in] &window		reference to the window (3xN, one sample per column)
 //! @param[out] &gravity	reference to the gravity comp. extracted from the window
 //! @param[out] &body		reference to the body acc. comp. extracted from the window
-void Classifier::analyzeWindow(mat &window, mat &gravity, mat &body)
+void Classifier::analyzeWindow(const rmat &window, rmat &gravity, rmat &body)
 {
-	// perform median filtering to reduce the noise
-	int n = 3;
-	mat clean_window = window.t();
-	medianFilter(clean_window, n);
-	clean_window = clean_window.t();
-
-	// discriminate between gravity and body acc. components
-	mat tempgr = clean_window.t();
-	gravity = ChebyshevFilter(tempgr);
-	gravity = gravity.t();
-	body = clean_window - gravity;
+	// (designed again only if a reload changed the filter of the dataset)
+	const FilterConfig &filter = currentSet()->filter;
+	if (!(filter == lowPass.config()))
+		lowPass.configure(filter);
+	analyzeWindow(window, gravity, body, lowPass);
 }
 
-//! compute (trial)point-to-(model)point Mahalanobis distance
-//! @param[in] index		index of the points (in trial and model) to be compared
-//! @param[in] &trial		reference to the trial
-//! @param[in] &model		reference to the model
-//! @param[in] &variance	reference to the model variance
-//! @return 			    Mahalanobis distance between trial-point and model-point
-float Classifier::mahalanobisDist(int index,mat &trial,mat &model,cube &variance)
+//! get gravity and body acc. components of the window (given filter)
+//! (one pass of the fused kernel shared with Creator: no intermediate
+//! copies, and no allocation once the outputs have the window size)
+//! @param[in] &window		reference to the window (3xN, one sample per column)
+//! @param[out] &gravity	reference to the gravity comp. extracted from the window
+//! @param[out] &body		reference to the body acc. comp. extracted from the window
+//! @param[in,out] &filter	reference to the (designed) low-pass filter
+void Classifier::analyzeWindow(const rmat &window, rmat &gravity, rmat &body,
+							   GravityFilter &filter)
 {
-	mat difference = trial.col(index) - model.col(index);
-	mat distance = (difference.t() * (variance.slice(index)).i()) * difference;
-
-	return distance(0,0);
+	// median filtering to reduce the noise, then gravity and body acc.
+	// (features are stored one sample per column, as the models points;
+	// every window is filtered from a clean state)
+	int n = 3;
+	gravity.set_size(window.n_rows, window.n_cols);
+	body.set_size(window.n_rows, window.n_cols);
+	extractFeatures(window.memptr(), window.n_cols, window.n_rows, 1, n, filter,
+					gravity.memptr(), body.memptr());
 }
 
+//! number of model points scored between two threshold checks (early exit)
+static const int EXIT_BLOCK = 8;
+
 //! compute the overall distance between the trial and one model
-//! @param[in] &Tgravity	reference to the gravity component of the trial
-//! @param[in] &Tbody		reference to the body acc. component of the trial
+//! (early exit: once the weighted partial distance reaches the threshold the
+//! possibility is 0 whatever the remaining points, and scoring stops)
+//! @param[in] &Tgravity	reference to the gravity component of the trial (3xN)
+//! @param[in] &Tbody		reference to the body acc. component of the trial (3xN)
 //! @param[in] &MODEL		reference to the model
+//! @param[out] &scored		number of model points actually scored
 //! @return 			    Mahalanobis overall distance between trial and model
-float Classifier::compareOne(mat &Tgravity, mat &Tbody, DYmodel &MODEL)
+//!							(early exit: a lower bound, not below the threshold)
+float Classifier::compareOne(const rmat &Tgravity, const rmat &Tbody,
+							 const DYmodel &MODEL, int &scored)
 {
-	// extract the subwindow of interest from the trial (same size of the model)
-	mat gravity = Tgravity.rows(0, MODEL.size-1);
-	mat body = Tbody.rows(0, MODEL.size-1);
-
-	// acquire the relevant data from the model class
-	mat MODELgP = MODEL.gP;
-	cube MODELgS = MODEL.gS;
-	mat MODELbP = MODEL.bP;
-	cube MODELbS = MODEL.bS;
+	const real_t* Tg = Tgravity.memptr();
+	const real_t* Tb = Tbody.memptr();
+	double distanceG = 0;
+	double distanceB = 0;
 
-	// discard the "time" row from the models
-	int numPoints = MODELgS.n_slices;
-	gravity = gravity.t();
-	body = body.t();
-
-	mat reference_G = zeros<mat>(3, MODELgP.n_cols);
-	mat reference_B = zeros<mat>(3, MODELbP.n_cols);
-	for (int i = 0; i < 3; i++)
+	// compare the first MODEL.size points of the trial with the model points
+	// (batched kernel: AVX2 / SSE2 when supported by the host, scalar otherwise)
+	if (!earlyExit || MODEL.gravityWeight < 0 || MODEL.bodyWeight < 0)
 	{
-		reference_G.row(i) = MODELgP.row(i + 1);
-		reference_B.row(i) = MODELbP.row(i + 1);
+		distanceG = MODEL.gK.sum(Tg, MODEL.size);
+		distanceB = MODEL.bK.sum(Tb, MODEL.size);
+		scored = MODEL.size;
 	}
-
-	// compute the components distances (gravity; body acc.)
-	mat dist = zeros<mat>(numPoints,2);
-	for (int i = 0; i < numPoints; i++)
+	else
 	{
-		dist(i,0) = mahalanobisDist(i, gravity, reference_G, MODELgS);
-		dist(i,1) = mahalanobisDist(i, body, reference_B, MODELbS);
+		// the distances are non-negative: the partial sums can only grow
+		double bound = MODEL.threshold * MODEL.size;
+		scored = 0;
+		while (scored < MODEL.size)
+		{
+			int last = min(scored + EXIT_BLOCK, MODEL.size);
+			distanceG += MODEL.gK.sum(Tg, scored, last);
+			distanceB += MODEL.bK.sum(Tb, scored, last);
+			scored = last;
+			if ((MODEL.gravityWeight*distanceG)+(MODEL.bodyWeight*distanceB) >= bound)
+				break;
+		}
 	}
 
 	// compute the overall distance
-	float distanceG = mean(dist.col(0));
-	float distanceB = mean(dist.col(1));
+	distanceG = distanceG / MODEL.size;
+	distanceB = distanceB / MODEL.size;
 	float overall = (MODEL.gravityWeight*distanceG)+(MODEL.bodyWeight*distanceB);
 
 	return overall;
 }
 
+//! job of the worker pool comparing the trial with all the models
+//! (each thread compares a subset of the models; when the models are fewer
+//! than the threads, each thread computes the partial sums of a subset of
+//! the points of every model)
+class CompareJob : public WorkerPool::Job
+{
+	public:
+		Classifier* owner;			//!< classifier (scoring options)
+		const ModelSet* set;		//!< set of models
+		const rmat* gravity;		//!< gravity component of the trial
+		const rmat* body;			//!< body acc. component of the trial
+		float* distance;			//!< trial-to-model distances (split models)
+		int* scored;				//!< model points scored (split models)
+		double* partial;			//!< partial sums (split points)
+		bool splitPoints;			//!< flag --> split points instead of models
+
+		//! constructor
+		//! @param[in] *c			pointer to the classifier
+		//! @param[in] &m			reference to the set of models
+		//! @param[in] &g			reference to the gravity component of the trial
+		//! @param[in] &b			reference to the body acc. component of the trial
+		//! @param[out] *d			pointer to the trial-to-model distances
+		//! @param[out] *s			pointer to the model points scored
+		//! @param[out] *p			pointer to the partial sums (2 x threads x nbM)
+		CompareJob(Classifier* c, const ModelSet &m, const rmat &g, const rmat &b,
+				   float* d, int* s, double* p)
+		{
+			owner = c;
+			set = &m;
+			gravity = &g;
+			body = &b;
+			distance = d;
+			scored = s;
+			partial = p;
+			splitPoints = (m.nbM < c->nbThreads);
+		}
+
+		//! execute one part of the comparison
+		//! @param[in] part		index of the part
+		//! @param[in] nbParts	number of parts
+		void run(int part, int nbParts)
+		{
+			int nbM = set->nbM;
+			if (!splitPoints)
+			{
+				for (int i = part; i < nbM; i += nbParts)
+					distance[i] = owner->compareOne(*gravity, *body,
+													set->set[i], scored[i]);
+				return;
+			}
+			for (int i = 0; i < nbM; i++)
+			{
+				const DYmodel &MODEL = set->set[i];
+				int first = (MODEL.size * part) / nbParts;
+				int last = (MODEL.size * (part + 1)) / nbParts;
+				double* out = partial + 2 * (part * nbM + i);
+				out[0] = MODEL.gK.sum(gravity->memptr(), first, last);
+				out[1] = MODEL.bK.sum(body->memptr(), first, last);
+			}
+		}
+};
+
 //! compute the matching possibility of all the models
 //! @param[in] &gravity         reference to the gravity component of the trial
 //! @param[in] &body			reference to the body acc. component of the trial
 //! @param[out] &possibilities	reference to the models possibilities
-void Classifier::compareAll(mat &gravity,mat &body, vector<float> &possibilities)
+void Classifier::compareAll(const rmat &gravity, const rmat &body,
+							vector<float> &possibilities)
+{
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	compareAll(*set, gravity, body, possibilities);
+}
+
+//! compute the matching possibility of all the models of a given set
+//! @param[in] &set				reference to the set of models
+//! @param[in] &gravity         reference to the gravity component of the trial
+//! @param[in] &body			reference to the body acc. component of the trial
+//! @param[out] &possibilities	reference to the models possibilities
+void Classifier::compareAll(const ModelSet &set, const rmat &gravity,
+							const rmat &body, vector<float> &possibilities)
 {
+	int nbM = set.nbM;
 	float distance[nbM];
+	int scored[nbM];
 
 	// compare the features of the trial with those of each model
-	for(int i = 0; i < nbM; i++)
-    {
-		distance[i] = compareOne(gravity, body, set[i]);
-        //DEBUG: cout<<distance[i] <<endl;
-    }
+	if (pool == NULL)
+	{
+		for(int i = 0; i < nbM; i++)
+		{
+			distance[i] = compareOne(gravity, body, set.set[i], scored[i]);
+			//DEBUG: cout<<distance[i] <<endl;
+		}
+	}
+	else
+	{
+		// split the models (or, if they are few, their points) among the threads
+		// (the partial sums are shared: one comparison at a time on the pool)
+		boost::unique_lock<boost::mutex> guard(partialLock);
+		if (partial.size() < (unsigned int) (2 * nbThreads * nbM))
+			partial.resize(2 * nbThreads * nbM);
+		CompareJob job(this, set, gravity, body, distance, scored, &partial[0]);
+		pool->run(job);
+		if (job.splitPoints)
+		{
+			// (no early exit: every thread scores a slice of each model)
+			for(int i = 0; i < nbM; i++)
+			{
+				scored[i] = set.set[i].size;
+				double distanceG = 0;
+				double distanceB = 0;
+				for (int t = 0; t < nbThreads; t++)
+				{
+					distanceG += partial[2 * (t * nbM + i)];
+					distanceB += partial[2 * (t * nbM + i) + 1];
+				}
+				const DYmodel &MODEL = set.set[i];
+				distanceG = distanceG / MODEL.size;
+				distanceB = distanceB / MODEL.size;
+				distance[i] = (MODEL.gravityWeight * distanceG)
+							+ (MODEL.bodyWeight * distanceB);
+			}
+		}
+	}
+	if (earlyExit)
+		countScored(set, scored);
 
 	// compute the possibilities from the trial_to_model distances
-	for(int i = 0; i < nbM; i++)
+	computePossibilities(set, distance, possibilities);
+}
+
+//! get the matching possibility of all the models (incremental scoring)
+//! @param[in] &set				reference to the set of models (of the scorer)
+//! @param[in] &scorer			reference to the scorer of the causal features
+//! @param[out] &possibilities	reference to the models possibilities
+void Classifier::compareAll(const ModelSet &set, IncrementalScorer &scorer,
+							vector<float> &possibilities)
+{
+	float distance[set.nbM];
+
+	// read the distances of the last window from the running sums
+	for(int i = 0; i < set.nbM; i++)
+		distance[i] = scorer.distance(i);
+
+	// compute the possibilities from the trial_to_model distances
+	computePossibilities(set, distance, possibilities);
+}
+
+//! update the early exit counters with the points scored per model
+//! @param[in] &set		reference to the set of models
+//! @param[in] *scored	pointer to the number of points scored for each model
+void Classifier::countScored(const ModelSet &set, int* scored)
+{
+	boost::unique_lock<boost::mutex> guard(statsLock);
+	for(int i = 0; i < set.nbM; i++)
+	{
+		nbCompared = nbCompared + 1;
+		if (scored[i] < set.set[i].size)
+			nbShortCircuits = nbShortCircuits + 1;
+		pointsScored = pointsScored + scored[i];
+		pointsTotal = pointsTotal + set.set[i].size;
+	}
+}
+
+//! reset the early exit counters
+void Classifier::resetCounters()
+{
+	boost::unique_lock<boost::mutex> guard(statsLock);
+	nbCompared = 0;
+	nbShortCircuits = 0;
+	pointsScored = 0;
+	pointsTotal = 0;
+}
+
+//! print the early exit counters
+void Classifier::printCounters()
+{
+	boost::unique_lock<boost::mutex> guard(statsLock);
+	cout<<"Comparisons: " <<nbCompared <<" (stopped early: " <<nbShortCircuits;
+	if (nbCompared > 0)
+		cout<<", " <<(100.0 * nbShortCircuits) / nbCompared <<"%";
+	cout<<")" <<endl;
+	cout<<"Model points scored: " <<pointsScored <<" of " <<pointsTotal;
+	if (pointsTotal > 0)
+		cout<<" (" <<(100.0 * pointsScored) / pointsTotal <<"%)";
+	cout<<endl;
+}
+
+//! compute the possibilities from the trial-to-model distances
+//! @param[in] &set				reference to the set of models
+//! @param[in] *distance		pointer to the trial-to-model distances
+//! @param[out] &possibilities	reference to the models possibilities
+void Classifier::computePossibilities(const ModelSet &set, float* distance,
+									  vector<float> &possibilities)
+{
+	for(int i = 0; i < set.nbM; i++)
 	{
-		possibilities[i] = 1 - (distance[i] / set[i].threshold);
+		possibilities[i] = 1 - (distance[i] / set.set[i].threshold);
 		if (possibilities[i] < 0)
 			possibilities[i] = 0;
 	}
@@ -332,94 +979,194 @@ void Classifier::compareAll(mat &gravity,mat &body, vector<float> &possibilities
 //! @param[in] p    interface for the publishing middleware
 void Classifier::buildSet(string dF, Device* dev, Publisher* p)
 {
-	string one_HMPn;
-	float one_gW;
-	float one_bW;
-	float one_th;
-	DYmodel *one_model;
-
-	// delete the existing models
-	set.clear();
-
-	// load the new set of models
-	datasetFolder = "./Models/" + dF + "/";
     driver = dev;
     //DEBUG:driver->printInfo();
     pub = p;
     pub->printInfo();
-	string fileName = datasetFolder + "Classifierconfig.txt";
-	//DEBUG:cout<<"config file: " <<fileName <<endl;
-	ifstream configFile(fileName.c_str());
-	configFile >>nbM;
-	//DEBUG:cout<<"nbM: " <<nbM <<endl;
-	for(int i=0; i< nbM; i++)
+
+	// load the new set of models (the old one is released when unused)
+	adoptSet(boost::shared_ptr<const ModelSet>(new ModelSet(dF)));
+
+	// publish the static information (number & names of models)
+	publishStatic();
+}
+
+//! add one sample to a stream and classify its last window
+//! (the window and filter state are always updated, but only one window
+//! every hopSize samples is evaluated)
+//! @param[in] &one_sample	reference to the sample to be added to the stream
+//! @param[in,out] &s		reference to the state of the stream
+//! @return					true if the stream possibilities have been updated
+bool Classifier::classifySample(const mat &one_sample, Stream &s)
+{
+	// move the stream to the current set (if a new one has been swapped in)
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	if (s.models != set)
+		s.rebind(set);
+	int ws = set->window_size;
+
+	if (streaming || scoring == INCREMENTAL)
 	{
-		configFile>>one_HMPn >>one_gW >>one_bW >>one_th;
-		one_HMPn = datasetFolder + one_HMPn;
-		//DEBUG:cout<<"DYmodel: " <<one_HMPn <<endl;
-		one_model = new DYmodel(one_HMPn, one_gW, one_bW, one_th);
-		//DEBUG:one_model->printInfo();
-		set.push_back(*one_model);
+		// causal preprocessing: one new feature sample per raw sample
+		s.nSamples = s.nSamples + 1;
+		if (!s.pre.push(one_sample))
+			return false;
+		if (scoring == INCREMENTAL)
+			s.scorer->push(s.pre.gravity.last(), s.pre.body.last());
+		if (!s.pre.isFull())
+			return false;
+		if ((s.pre.gravity.count() - ws) % hopSize != 0)
+			return false;
+
+		s.past_possibilities = s.possibilities;
+		if (scoring == INCREMENTAL)
+			compareAll(*set, *s.scorer, s.possibilities);
+		else
+			compareAll(*set, s.pre.gravity.view(), s.pre.body.view(), s.possibilities);
 	}
-	configFile.close();
-    
-    // compute the size of the window
-    cout<<"HMP models loaded. Defining window size as: ";
-	int temp_ws = set[0].size;
-	for(int i=1; i< nbM; i++)
+	else
 	{
-		if(set[i].size > temp_ws)
-			temp_ws = set[i].size;
+		s.window.push(one_sample);
+		s.nSamples = s.nSamples + 1;
+		if (!s.window.isFull())
+			return false;
+		if ((s.window.count() - ws) % hopSize != 0)
+			return false;
+
+		s.past_possibilities = s.possibilities;
+		analyzeWindow(s.window.view(), s.gravity, s.body, s.lowPass);
+		compareAll(*set, s.gravity, s.body, s.possibilities);
 	}
-	window_size = temp_ws;
-    cout<<window_size <<endl;
 
-	// publish the static information (number & names of models)
-	publishStatic();
+	return true;
 }
 
 //! test one file (off-line)
 //! @param[in] testFile 	name of the test file
 //! @param[in] resultFile	name of the result file
 void Classifier::singleTest(string testFile, string resultFile)
+{
+	mat actualSample;				// current sample in matrix format
+	Stream stream(currentSet(), scoring == INCREMENTAL);
+
+	// create result file
+	ofstream outputFile;
+	outputFile.open(resultFile.c_str());
+
+	// read recorded data
+    ifstream tf(testFile.c_str());
+    cout <<"Reading trial: " <<testFile <<endl;
+    for (string line; std::getline(tf, line); )
+    {
+        //DEBUG:cout<<"Line: " <<line <<endl;
+        actualSample = driver->extractActual(line);
+		if (classifySample(actualSample, stream))
+		{
+			// report the sample index & possibility values in the results file
+			// (the set of the stream: a reload may change the number of models)
+			outputFile<<stream.nSamples <<" ";
+			for (int i = 0; i < stream.models->nbM; i++)
+				outputFile<<stream.possibilities[i] <<" ";
+			outputFile<<endl;
+		}
+	}
+	tf.close();
+	outputFile.close();
+}
+
+//! compare streaming and per-window preprocessing on one file (off-line)
+//! (each streaming window is compared with the per-window analysis of the
+//! same raw samples, i.e. the one computed medianSize/2 samples earlier)
+//! @param[in] testFile 	name of the test file
+//! @param[in] reportFile	name of the report file
+void Classifier::streamingTest(string testFile, string reportFile)
 {
 	int nSamples = 0;				// number of samples acquired by the system
+	int nWindows = 0;				// number of compared windows
 	mat actualSample;				// current sample in matrix format
-	vector<float> possibilities;	// models possibilities
+	vector<float> batchPoss;		// possibilities (per-window preprocessing)
+	vector<float> pastPoss;			// possibilities of the previous window
+	vector<float> streamPoss;		// possibilities (streaming preprocessing)
+	bool past = false;				// flag --> previous window available
+	double maxG = 0, maxB = 0, maxP = 0;
+	double sumG = 0, sumB = 0, sumP = 0;
 
-	mat window = zeros<mat>(window_size, 3);
-	mat gravity = zeros<mat>(window_size, 3);
-	mat body = zeros<mat>(window_size, 3);
+	// (one set for the whole trial, even if a reload swaps a new one in)
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	int nbM = set->nbM;
+	int window_size = set->window_size;
+	SampleBuffer window(window_size);
+	Preprocessor pre(window_size, set->filter);
+	GravityFilter filter(set->filter);
+	rmat gravity, body, pastGravity, pastBody;
 
 	// initialize the possibilities
 	for (int i = 0; i < nbM; i++)
-		possibilities.push_back(0);
+	{
+		batchPoss.push_back(0);
+		pastPoss.push_back(0);
+		streamPoss.push_back(0);
+	}
 
-	// create result file
+	// create report file
 	ofstream outputFile;
-	outputFile.open(resultFile.c_str());
+	outputFile.open(reportFile.c_str());
 
 	// read recorded data
     ifstream tf(testFile.c_str());
     cout <<"Reading trial: " <<testFile <<endl;
     for (string line; std::getline(tf, line); )
     {
-        //DEBUG:cout<<"Line: " <<line <<endl;
         actualSample = driver->extractActual(line);
-        createWindow(actualSample, window, window_size, nSamples);
-		if (nSamples >= window_size)
+        createWindow(actualSample, window, nSamples);
+
+		// streaming features vs. previous per-window features
+		if (pre.push(actualSample) && pre.isFull() && past)
 		{
-			analyzeWindow(window, gravity, body);
-			compareAll(gravity, body, possibilities);
-			
-			// report the possibility values in the results file
+			compareAll(*set, pre.gravity.view(), pre.body.view(), streamPoss);
+			double dG = abs(pre.gravity.view() - pastGravity).max();
+			double dB = abs(pre.body.view() - pastBody).max();
+			double dP = 0;
 			for (int i = 0; i < nbM; i++)
-				outputFile<<possibilities[i] <<" ";
-			outputFile<<endl;
+			{
+				double d = fabs(streamPoss[i] - pastPoss[i]);
+				if (d > dP)
+					dP = d;
+			}
+
+			// report the differences in the report file
+			outputFile<<dG <<" " <<dB <<" " <<dP <<endl;
+			maxG = (dG > maxG) ? dG : maxG;
+			maxB = (dB > maxB) ? dB : maxB;
+			maxP = (dP > maxP) ? dP : maxP;
+			sumG += dG;
+			sumB += dB;
+			sumP += dP;
+			nWindows = nWindows + 1;
+		}
+
+		// per-window preprocessing
+		if (nSamples >= window_size)
+		{
+			analyzeWindow(window.view(), gravity, body, filter);
+			compareAll(*set, gravity, body, batchPoss);
+			pastGravity = gravity;
+			pastBody = body;
+			pastPoss = batchPoss;
+			past = true;
 		}
 	}
 	tf.close();
 	outputFile.close();
+
+	// summary of the trial (max / mean absolute differences)
+	if (nWindows > 0)
+	{
+		cout<<"Compared windows: " <<nWindows <<endl;
+		cout<<"gravity: max " <<maxG <<" mean " <<sumG / nWindows <<endl;
+		cout<<"body acc.: max " <<maxB <<" mean " <<sumB / nWindows <<endl;
+		cout<<"possibilities: max " <<maxP <<" mean " <<sumP / nWindows <<endl;
+	}
 }
 
 //! validate one model with given validation trials
@@ -435,60 +1182,507 @@ void Classifier::validateModel(string model, string dataset, int numTrials)
 		itos<<i+1;
 		string trial = model + "_test (" + itos.str() + ").txt";
 		string tf = "Validation/" + dataset + "/" + trial;
-		string rf = "Results/" + dataset + "/res_" + trial;
+		string rf = "Results/" + dataset + "/" + RESULTS_PREFIX + trial;
 		singleTest(tf, rf);
   	}
 }
 
+//! compare streaming and per-window preprocessing on given validation trials
+//! @param[in] model		name of the model to be validated
+//! @param[in] dataset		name of the referring dataset
+//! @param[in] numTrials	number of validation trials to be used
+void Classifier::compareStreaming(string model, string dataset, int numTrials)
+{
+	// analyze all validating trials one by one
+	for (int i = 0; i < numTrials; i++)
+	{
+		stringstream itos;
+		itos<<i+1;
+		string trial = model + "_test (" + itos.str() + ").txt";
+		string tf = "Validation/" + dataset + "/" + trial;
+		string rf = "Results/" + dataset + "/streaming_" + trial;
+		streamingTest(tf, rf);
+  	}
+}
+
+//! compare incremental and batch scoring on one file (off-line)
+//! (the same causal features are scored by the running sums and from scratch
+//! by compareAll: distances and possibilities should match up to rounding)
+//! @param[in] testFile 	name of the test file
+//! @param[in] reportFile	name of the report file
+void Classifier::incrementalTest(string testFile, string reportFile)
+{
+	int nWindows = 0;				// number of compared windows
+	mat actualSample;				// current sample in matrix format
+	double maxD = 0, maxP = 0;
+	double sumD = 0, sumP = 0;
+
+	// (one set for the whole trial; every model fully scored by compareAll)
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	int nbM = set->nbM;
+	Preprocessor pre(set->window_size, set->filter);
+	IncrementalScorer scorer(set->set, set->window_size);
+	vector<float> batchPoss(nbM, 0);
+	vector<float> incPoss(nbM, 0);
+	bool wasEarly = earlyExit;
+	earlyExit = false;
+
+	// create report file
+	ofstream outputFile;
+	outputFile.open(reportFile.c_str());
+
+	// read recorded data
+    ifstream tf(testFile.c_str());
+    cout <<"Reading trial: " <<testFile <<endl;
+    for (string line; std::getline(tf, line); )
+    {
+        actualSample = driver->extractActual(line);
+		if (!pre.push(actualSample))
+			continue;
+		scorer.push(pre.gravity.last(), pre.body.last());
+		if (!pre.isFull())
+			continue;
+
+		// distances: running sums vs. scoring from scratch
+		double dD = 0;
+		for (int i = 0; i < nbM; i++)
+		{
+			int scored;
+			float batch = compareOne(pre.gravity.view(), pre.body.view(),
+									 set->set[i], scored);
+			double d = fabs(scorer.distance(i) - batch);
+			if (d > dD)
+				dD = d;
+		}
+
+		// possibilities
+		compareAll(*set, scorer, incPoss);
+		compareAll(*set, pre.gravity.view(), pre.body.view(), batchPoss);
+		double dP = 0;
+		for (int i = 0; i < nbM; i++)
+		{
+			double d = fabs(incPoss[i] - batchPoss[i]);
+			if (d > dP)
+				dP = d;
+		}
+
+		// report the differences in the report file
+		outputFile<<dD <<" " <<dP <<endl;
+		maxD = (dD > maxD) ? dD : maxD;
+		maxP = (dP > maxP) ? dP : maxP;
+		sumD += dD;
+		sumP += dP;
+		nWindows = nWindows + 1;
+	}
+	tf.close();
+	outputFile.close();
+	earlyExit = wasEarly;
+
+	// summary of the trial (max / mean absolute differences)
+	if (nWindows > 0)
+	{
+		cout<<"Compared windows: " <<nWindows <<endl;
+		cout<<"distances: max " <<maxD <<" mean " <<sumD / nWindows <<endl;
+		cout<<"possibilities: max " <<maxP <<" mean " <<sumP / nWindows <<endl;
+	}
+}
+
+//! compare incremental and batch scoring on given validation trials
+//! @param[in] model		name of the model to be validated
+//! @param[in] dataset		name of the referring dataset
+//! @param[in] numTrials	number of validation trials to be used
+void Classifier::compareIncremental(string model, string dataset, int numTrials)
+{
+	// analyze all validating trials one by one
+	for (int i = 0; i < numTrials; i++)
+	{
+		stringstream itos;
+		itos<<i+1;
+		string trial = model + "_test (" + itos.str() + ").txt";
+		string tf = "Validation/" + dataset + "/" + trial;
+		string rf = "Results/" + dataset + "/incremental_" + trial;
+		incrementalTest(tf, rf);
+  	}
+}
+
+//! publisher "ResultCapture", keeps the recognition results of one stream
+//! (off-line checks: nothing is published)
+class ResultCapture : public Publisher
+{
+	public:
+		vector<int> samples;				//!< last sample of each window
+		vector< vector<float> > results;	//!< possibilities of each window
+
+		//! constructor
+		ResultCapture() : Publisher("ResultCapture")
+		{
+		}
+
+		//! publish information (strings: nothing to keep)
+		void publish(const string, const string)
+		{
+		}
+
+		//! keep the dynamic information (recognition results)
+		//! @param[in] &r	reference to the recognition results
+		void publishResults(const ResultRecord &r)
+		{
+			samples.push_back(r.sample);
+			results.push_back(vector<float>(r.possibilities,
+											r.possibilities + r.nbM));
+		}
+};
+
+//! compare multi-wearer (server) and single-stream classification
+//! (each trial is the stream of one wearer: the server classifies all the
+//! trials at once on the shared set of models, then each trial is classified
+//! alone on one stream; the results of every window should be identical)
+//! @param[in] model		name of the model to be validated
+//! @param[in] dataset		name of the referring dataset
+//! @param[in] numTrials	number of validation trials (wearers) to be used
+void Classifier::compareServer(string model, string dataset, int numTrials)
+{
+	// read the validation trials (one wearer each)
+	vector< vector<mat> > trials(numTrials);
+	unsigned int longest = 0;
+	for (int i = 0; i < numTrials; i++)
+	{
+		stringstream itos;
+		itos<<i+1;
+		string tf = "Validation/" + dataset + "/" + model + "_test (" + itos.str() + ").txt";
+		ifstream trial(tf.c_str());
+		cout <<"Reading trial: " <<tf <<endl;
+		for (string line; std::getline(trial, line); )
+			trials[i].push_back(driver->extractActual(line));
+		trial.close();
+		longest = max(longest, (unsigned int) trials[i].size());
+	}
+
+	// reference: one trial at a time on a single stream
+	vector<ResultCapture> single(numTrials);
+	for (int i = 0; i < numTrials; i++)
+	{
+		Stream stream(currentSet(), scoring == INCREMENTAL);
+		for (unsigned int k = 0; k < trials[i].size(); k++)
+		{
+			if (classifySample(trials[i][k], stream))
+				publishDynamic(stream, &single[i]);
+		}
+	}
+
+	// all the wearers at once (samples interleaved, one worker per wearer)
+	vector<ResultCapture> wearers(numTrials);
+	{
+		Server server(*this, numTrials);
+		vector<int> ids;
+		for (int i = 0; i < numTrials; i++)
+			ids.push_back(server.openSession(&wearers[i]));
+		for (unsigned int k = 0; k < longest; k++)
+			for (int i = 0; i < numTrials; i++)
+			{
+				if (k < trials[i].size())
+					server.push(ids[i], trials[i][k]);
+			}
+		server.drain();
+	}
+
+	// compare the windows of each wearer
+	for (int i = 0; i < numTrials; i++)
+	{
+		double largest = 0;
+		bool sameWindows = (single[i].samples == wearers[i].samples);
+		for (unsigned int w = 0; sameWindows && w < single[i].results.size(); w++)
+			for (unsigned int j = 0; j < single[i].results[w].size(); j++)
+			{
+				double d = fabs(single[i].results[w][j] - wearers[i].results[w][j]);
+				largest = (d > largest) ? d : largest;
+			}
+		cout<<"Wearer " <<i+1 <<": " <<wearers[i].results.size() <<" windows";
+		if (sameWindows)
+			cout<<", largest difference from a single stream: " <<largest <<endl;
+		else
+			cout<<", windows differ from a single stream (" <<single[i].results.size()
+				<<" windows)" <<endl;
+	}
+}
+
+//! compare the double and single precision results of one trial (off-line)
+//! (rows are matched by sample index: both builds must use the same hop size)
+//! @param[in] doubleFile	name of the results file of the double precision build
+//! @param[in] floatFile	name of the results file of the single precision build
+void Classifier::precisionTest(string doubleFile, string floatFile)
+{
+	ifstream df(doubleFile.c_str());
+	ifstream ff(floatFile.c_str());
+	if (!df || !ff)
+	{
+		cerr<<"Missing results file: run the validation with both builds" <<endl;
+		return;
+	}
+
+	int nRows = 0;					// number of compared rows
+	int nSwaps = 0;					// rows with a different highest model
+	double maxP = 0, sumP = 0;
+	int indexD, indexF;
+	int nbM = currentSet()->nbM;
+	vector<float> possD(nbM), possF(nbM);
+	cout <<"Comparing: " <<doubleFile <<" - " <<floatFile <<endl;
+	while (df >>indexD && ff >>indexF)
+	{
+		for (int i = 0; i < nbM; i++)
+			df>>possD[i];
+		for (int i = 0; i < nbM; i++)
+			ff>>possF[i];
+		if (indexD != indexF)
+		{
+			cerr<<"Sample indexes do not match: " <<indexD <<" " <<indexF <<endl;
+			break;
+		}
+
+		// largest possibility difference and highest model of the row
+		int bestD = 0, bestF = 0;
+		for (int i = 0; i < nbM; i++)
+		{
+			double d = fabs(possD[i] - possF[i]);
+			maxP = (d > maxP) ? d : maxP;
+			sumP += d;
+			bestD = (possD[i] > possD[bestD]) ? i : bestD;
+			bestF = (possF[i] > possF[bestF]) ? i : bestF;
+		}
+		if (possD[bestD] == 0)
+			bestD = -1;
+		if (possF[bestF] == 0)
+			bestF = -1;
+		if (bestD != bestF)
+			nSwaps = nSwaps + 1;
+		nRows = nRows + 1;
+	}
+	df.close();
+	ff.close();
+
+	// summary of the trial
+	if (nRows > 0)
+	{
+		cout<<"Compared windows: " <<nRows <<endl;
+		cout<<"possibilities: max " <<maxP <<" mean " <<sumP / (nRows * nbM) <<endl;
+		cout<<"different highest model: " <<nSwaps <<endl;
+	}
+}
+
+//! compare the double and single precision results of given validation trials
+//! (both builds must have validated the model: see validateModel)
+//! @param[in] model		name of the validated model
+//! @param[in] dataset		name of the referring dataset
+//! @param[in] numTrials	number of validation trials to be used
+void Classifier::comparePrecision(string model, string dataset, int numTrials)
+{
+	// compare all validating trials one by one
+	for (int i = 0; i < numTrials; i++)
+	{
+		stringstream itos;
+		itos<<i+1;
+		string trial = model + "_test (" + itos.str() + ").txt";
+		string df = "Results/" + dataset + "/res_" + trial;
+		string ff = "Results/" + dataset + "/res32_" + trial;
+		precisionTest(df, ff);
+  	}
+}
+
+//! measure the per-point cost of the Mahalanobis distance (gravity of model 0)
+//! (dynamic Armadillo objects with and without the inversion of each
+//! covariance matrix, fixed-size tri-axial types, batched SoA kernel)
+//! @param[in] repetitions	number of scans of the model points
+void Classifier::benchmarkPoint(int repetitions)
+{
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	const DYmodel &MODEL = set->set[0];
+	int n = MODEL.size;
+	double points = (double) n * repetitions;
+	double sink = 0;
+
+	// (views on the model data: mapped or loaded from the text files)
+	const mat gP = MODEL.mu(GRAVITY_MU);
+	const cube gS = MODEL.sigma(GRAVITY_SIGMA);
+	const cube gSi = MODEL.sigma(GRAVITY_INVERSE);
+
+	// synthetic trial: the model points, shifted
+	mat trial = gP + 0.1;
+	rmat rtrial = conv_to<rmat>::from(trial);
+	cout<<"Per-point distance cost (" <<MODEL.HMPname <<", " <<n <<" points):" <<endl;
+
+	// dynamic objects, covariance inverted at each point (original code)
+	ptime start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+		for (int j = 0; j < n; j++)
+		{
+			mat difference = trial.col(j) - gP.col(j);
+			mat distance = (difference.t() * (gS.slice(j)).i()) * difference;
+			sink += distance(0, 0);
+		}
+	double ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"dynamic, inverse per point:  " <<ns / points <<" ns" <<endl;
+
+	// dynamic objects, precomputed inverse
+	start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+		for (int j = 0; j < n; j++)
+		{
+			mat difference = trial.col(j) - gP.col(j);
+			mat distance = (difference.t() * gSi.slice(j)) * difference;
+			sink += distance(0, 0);
+		}
+	ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"dynamic, precomputed inverse: " <<ns / points <<" ns" <<endl;
+
+	// fixed-size types, precomputed inverse
+	start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+		for (int j = 0; j < n; j++)
+		{
+			Vec3<double> difference = Vec3<double>(trial.colptr(j))
+									- Vec3<double>(gP.colptr(j));
+			SymMat3<double> S = SymMat3<double>::fromFull(gSi.slice_memptr(j));
+			sink += S.quadraticForm(difference);
+		}
+	ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"fixed-size 3-vector / 3x3:    " <<ns / points <<" ns" <<endl;
+
+	// batched SoA kernel
+	start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+		sink += MODEL.gK.sum(rtrial.memptr(), n);
+	ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"batched kernel (" <<MahalanobisKernel::instructionSet() <<"):"
+		<<"\t     " <<ns / points <<" ns" <<endl;
+
+	// (print the checksum, so that no loop is optimized away)
+	cout<<"checksum: " <<sink <<endl;
+}
+
+//! compare the scalar and the interleaved (SIMD) gravity filters
+//! (per-sample cost on windows of the current set, and largest difference
+//! between the outputs: the lanes repeat the scalar arithmetic)
+//! @param[in] repetitions	number of filtered windows
+void Classifier::benchmarkFilter(int repetitions)
+{
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	const FilterConfig &config = set->filter;
+	int n = set->window_size;
+	double samples = (double) n * repetitions;
+
+	// synthetic window: slow "gravity" plus fast "body" components
+	rmat window(3, n);
+	for (int i = 0; i < n; i++)
+		for (int axis = 0; axis < 3; axis++)
+			window(axis, i) = 1000 * sin(0.01 * i + axis)
+							  + 200 * sin(1.3 * i * (axis + 1));
+	cout<<"Per-sample gravity filter cost (" <<config.samplingRate <<" Hz, "
+		<<config.cutoff <<" Hz cutoff, " <<n <<" samples):" <<endl;
+
+	// scalar cascades, one axis after the other (DspFilters SimpleFilter)
+	ChebyshevLowPass scalar;
+	scalar.setup(GravityFilter::ORDER, config.samplingRate, config.cutoff,
+				 config.ripple);
+	rmat scalarOut = window;
+	ptime start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+	{
+		scalarOut = window;
+		scalar.reset();
+		scalar.processStrided(n, scalarOut.memptr(), 3, 1);
+	}
+	double ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"scalar cascade:		  " <<ns / samples <<" ns" <<endl;
+
+	// interleaved cascade, the 3 axes at once
+	GravityFilter interleaved(config);
+	rmat lanesOut = window;
+	start = microsec_clock::local_time();
+	for (int r = 0; r < repetitions; r++)
+	{
+		lanesOut = window;
+		interleaved.reset();
+		interleaved.processStrided(n, lanesOut.memptr(), 3, 1);
+	}
+	ns = (microsec_clock::local_time() - start).total_microseconds() * 1000.0;
+	cout<<"interleaved cascade (" <<Dsp::InterleavedCascade::instructionSet() <<"): "
+		<<ns / samples <<" ns" <<endl;
+
+	// (same input, same state: the outputs should be identical)
+	real_t largest = 0;
+	for (int i = 0; i < 3 * n; i++)
+		largest = max(largest, (real_t) fabs(scalarOut(i) - lanesOut(i)));
+	cout<<"largest difference: " <<largest <<endl;
+}
+
 //! test one recorded file
 //! @param[in] testFile	name of the test file
 void Classifier::longTest(string testFile)
 {
 	string tf = "Validation/longTest/" + testFile;
-	string rf = "Results/longTest/res_" + testFile;
+	string rf = "Results/longTest/" + RESULTS_PREFIX + testFile;
 	singleTest(tf, rf);
 }
 
 //! publish the static information (loaded HMPs)
 void Classifier::publishStatic()
 {
-	// HMP.numModels
-	stringstream ntos;
-	ntos<<nbM;
-	const char* sNumModels = ntos.str().c_str();
-    pub->publish("numModels", sNumModels);
-	//DEBUG: cout<<"numModels: " <<sNumModels <<endl;
-
-	//HMP.nameModels
-	string short_name;
-	string allNames;
-	int nRemove = datasetFolder.size();
-	for(int i=0; i<nbM; i++)
-	{
-		short_name = set[i].HMPname.erase(0,nRemove);
-		//DEBUG: cout<<short_name <<endl;
-		allNames = allNames + short_name + " ";
-	}
-	const char* sNameModels = allNames.c_str();
-	pub->publish("nameModels", sNameModels);
-	//DEBUG: cout<<"nameModels: " <<sNameModels <<endl;
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	publishStatic(*set, pub);
+}
+
+//! publish the static information of a set on a given publisher
+//! @param[in] &set		reference to the set of models
+//! @param[in] *target	interface for the publishing middleware
+void Classifier::publishStatic(const ModelSet &set, Publisher* target)
+{
+	// HMP.numModels, HMP.nameModels
+	ModelsRecord m;
+	m.nbM = set.nbM;
+	m.names = &set.names[0];
+	target->publishModels(m);
 }
 
 //! publish the dynamic information (recognition results)
 //! @param[in] &possibilities	reference to the models possibilities
 void Classifier::publishDynamic(vector<float> &possibilities)
 {
-	// HMP.possibilities
-	string p;
-	for(int i=0; i<nbM; i++)
+	publishDynamic(possibilities, pub);
+}
+
+//! publish the dynamic information on a given publisher
+//! @param[in] &possibilities	reference to the models possibilities
+//! @param[in] *target		interface for the publishing middleware
+void Classifier::publishDynamic(vector<float> &possibilities, Publisher* target)
+{
+	boost::shared_ptr<const ModelSet> set = currentSet();
+	publishDynamic(*set, possibilities, target, -1);
+}
+
+//! publish the dynamic information of one stream on a given publisher
+//! (after a swap of the models, the new static information is published first)
+//! @param[in,out] &s	reference to the stream
+//! @param[in] *target	interface for the publishing middleware of the stream
+void Classifier::publishDynamic(Stream &s, Publisher* target)
+{
+	if (s.changed)
 	{
-		stringstream ptos;
-		ptos<<possibilities[i];
-		p = p + " " + ptos.str();
+		publishStatic(*s.models, target);
+		s.changed = false;
 	}
-	const char* sPossibilities = p.c_str();
-	pub->publish("possibilities", sPossibilities);
-	//DEBUG: cout<<"possibilities: " <<sPossibilities <<endl;
+	publishDynamic(*s.models, s.possibilities, target, s.nSamples);
+}
+
+//! publish the dynamic information of a set on a given publisher
+//! (the record holds the numbers: each publisher formats them, if ever)
+//! @param[in] &set				reference to the set of models
+//! @param[in] &possibilities	reference to the models possibilities
+//! @param[in] *target			interface for the publishing middleware
+//! @param[in] sample			index of the last sample of the window
+void Classifier::publishDynamic(const ModelSet &set, const vector<float> &possibilities,
+								Publisher* target, int sample)
+{
+	int nbM = set.nbM;
 
 	// identify the models with highest and second-highest possibility
 	int best = 0;
@@ -508,41 +1702,15 @@ void Classifier::publishDynamic(vector<float> &possibilities)
 	if (possibilities[secondBest] == 0)
 		secondBest = -1;
 
-	// HMP.highest
-	string highest;				
-	if (best == -1)
-		highest = "NONE";
-	else
-		highest = set[best].HMPname;
-	const char* sHighest = highest.c_str();
-	pub->publish("highest", sHighest);
-	//DEBUG: cout<<"highest: " <<sHighest <<endl;
-
-	// HMP.other
-	float other;
-	if (best == -1)
-		other = 1;
-	else
-		other = 1 - possibilities[best];
-	stringstream str_other;
-	str_other<<other;
-	const char* sOther = str_other.str().c_str();
-	pub->publish("other", sOther);
-	//DEBUG: cout<<"highest: " <<sHighest <<" other: " <<sOther <<endl;
-
-	// HMP.entropy
-	float entropy;
-	if (best == -1)
-		entropy = -1;
-	else if (secondBest == -1)
-		entropy = possibilities[best];
-	else
-		entropy = possibilities[best] - possibilities[secondBest];
-	stringstream str_entropy;
-	str_entropy<<entropy;
-	const char* sEntropy = str_entropy.str().c_str();
-	pub->publish("entropy", sEntropy);
-	//DEBUG: cout<<"highest: " <<sHighest <<" entropy: " <<sEntropy <<endl;
+	// HMP.possibilities, HMP.highest, HMP.other, HMP.entropy
+	ResultRecord r;
+	r.sample = sample;
+	r.nbM = nbM;
+	r.possibilities = &possibilities[0];
+	r.names = &set.names[0];
+	r.best = best;
+	r.secondBest = secondBest;
+	target->publishResults(r);
 }
 
 /*
@@ -560,9 +1728,9 @@ void Classifier::onlineTest(char* port)
 	string motion;					// flag --> level of motion at the wrist
 	vector<float> possibilities;	// models possibilities
 
-	mat window = zeros<mat>(window_size, 3);
-	mat gravity = zeros<mat>(window_size, 3);
-	mat body = zeros<mat>(window_size, 3);
+	SampleBuffer window(window_size);
+	rmat gravity = zeros<rmat>(3, window_size);
+	rmat body = zeros<rmat>(3, window_size);
 
 	// initialize the possibilities
 	for (int i = 0; i < nbM; i++)
@@ -593,11 +1761,11 @@ void Classifier::onlineTest(char* port)
 			//DEBUG: cout<<"Acquired: " <<ax <<" " <<ay <<" " <<az <<" ";
 
 			// update the window of samples to be analyzed
-			createWindow(actsample, window, window_size, nSamples);
-			if (nSamples >= window_size)
+			createWindow(actsample, window, nSamples);
+			if ((nSamples >= window_size) && ((nSamples - window_size) % hopSize == 0))
 			{
 				// analyze the window and compute the models possibilities
-				analyzeWindow(window, gravity, body);
+				analyzeWindow(window.view(), gravity, body);
 				compareAll(gravity, body, possibilities);
 
 				// publish the dynamic tuples
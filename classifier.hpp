@@ -8,9 +8,16 @@
 
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "device.hpp"
+#include "mahalanobis.hpp"
+#include "modelfile.hpp"
+#include "preprocessor.hpp"
 #include "publisher.hpp"
+#include "samplebuffer.hpp"
 #include "utils.hpp"
+#include "workerpool.hpp"
 
 using namespace arma;
 using namespace std;
@@ -28,20 +35,46 @@ class DYmodel
 		//! load the expected variances (Sigma) of one feature
 		cube loadSigma(string name, string component);
 
+		//! compute the inverse of each covariance matrix of one feature
+		cube invertSigma(cube &sigma);
+
+		//! load the model from its text files
+		void loadText();
+
+		//! load the model from its binary file
+		bool loadBinary(string fileName);
+
+		//! use the mapped blocks of the model (binary model file or dataset pack)
+		void useBlocks(const double* const* blocks);
+
+		const double* mapped[NB_MODEL_BLOCKS];	//!< mapped blocks (NULL: text)
+
 	public:
 		string HMPname;			//!< name of the HMP within the dataset
 		int size;				//!< number of samples in the model
 		float gravityWeight;	//!< weight of gravity feature for classification
 		float bodyWeight;		//!< weight of body acc. feature for classification
 		float threshold;		//!< max distance for possible motion occurrence
-		mat gP;					//!< gravity expected points
+		// (loaded from the text files; empty when the model is mapped: read
+		// the points and matrices of any model through mu/sigma)
+		mat gP;					//!< gravity expected points (time row discarded)
 		cube gS;				//!< gravity set of covariance matrices
-		mat bP;					//!< body acc. expected points
+		mat bP;					//!< body acc. expected points (time row discarded)
 		cube bS;				//!< body acc. set of covariance matrices
+		cube gSi;				//!< gravity set of inverse covariance matrices
+		cube bSi;				//!< body acc. set of inverse covariance matrices
+		MahalanobisKernel gK;	//!< gravity distance kernel (SoA points, inverses)
+		MahalanobisKernel bK;	//!< body acc. distance kernel (SoA points, inverses)
+		boost::shared_ptr<const void> mapping;	//!< mapped file (empty: text)
+		float loadTime;			//!< time spent loading the model (ms)
 
 		//! constructor
 		DYmodel()
 		{
+			size = 0;
+			loadTime = 0;
+			for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+				mapped[b] = NULL;
 			//DEBUG:cout<<endl <<"Creating DYmodel object" <<endl;
 		}
 
@@ -49,11 +82,40 @@ class DYmodel
 		DYmodel(string HMPn, float gW, float bW, float th);
 
 		//! print model information
-		void printInfo();
+		void printInfo() const;
 
 		//! set all the model variables and load the model
 		void build(string HMPn, float gW, float bW, float th);
 
+		//! set all the model variables and use the model of a dataset pack
+		void build(boost::shared_ptr<const DatasetPack> pack, int i);
+
+		//! get one block of the model (mapped or loaded from the text files)
+		const double* block(ModelBlock b) const;
+
+		//! get the expected points of one feature (view on the model data)
+		//! @param[in] b	block of the points (GRAVITY_MU or BODY_MU)
+		//! @return			3xsize matrix using the model memory (no copy)
+		mat mu(ModelBlock b) const
+		{
+			return mat(const_cast<double*>(block(b)), 3, size, false, true);
+		}
+
+		//! get the (inverse) covariance matrices of one feature (view on the
+		//! model data)
+		//! @param[in] b	block of the matrices (GRAVITY_SIGMA, BODY_INVERSE, ...)
+		//! @return			3x3xsize cube using the model memory (no copy)
+		cube sigma(ModelBlock b) const
+		{
+			return cube(const_cast<double*>(block(b)), 3, 3, size, false, true);
+		}
+
+		//! write the binary file of the model
+		void save(string fileName) const;
+
+		//! convert the text files of a model into its binary file
+		void convert(string HMPn);
+
 		//! destructor
 		~DYmodel()
 		{
@@ -61,35 +123,174 @@ class DYmodel
 		}
 };
 
+//! class "ModelSet", set of HMP models of one dataset
+//! (loaded once and never modified: it can be shared by several
+//! classifiers and by all the sessions of a server)
+class ModelSet
+{
+	public:
+		string datasetName;		//!< name of the dataset
+		string datasetFolder;   //!< folder containing the models
+		int nbM;			    //!< number of considered models
+		vector<DYmodel> set;	//!< set of considered models
+		vector<string> names;	//!< names of the models (for the publishers)
+		int window_size;		//!< size of the largest stored model
+		FilterConfig filter;	//!< configuration of the gravity filter
+		boost::shared_ptr<const DatasetPack> pack;	//!< dataset pack (empty: loose files)
+
+		//! constructor (loads the models)
+		ModelSet(string dF, int nT = 0);
+
+		//! print set information
+		void printInfo() const;
+
+		//! convert the text files of a dataset (model files and dataset pack)
+		static void convert(string dF);
+
+		//! destructor
+		~ModelSet()
+		{
+			set.clear();
+			//DEBUG:cout<<endl <<"Destroying ModelSet object" <<endl;
+		}
+};
+
+class IncrementalScorer;
+
+//! class "Stream", classification state of one stream of samples (one wearer)
+//! (the models are not part of the state: memory scales with the windows;
+//! the stream keeps the set it is built for alive until it moves to a new one)
+class Stream
+{
+	private:
+		//! copy constructor (not allowed: the scorer is owned by the stream)
+		Stream(const Stream &other);
+
+		//! assignment operator (not allowed: the scorer is owned by the stream)
+		Stream& operator=(const Stream &other);
+
+	public:
+		boost::shared_ptr<const ModelSet> models;	//!< set the state is built for
+		bool changed;				//!< flag --> set changed since last publication
+		int nSamples;				//!< number of samples acquired by the stream
+		SampleBuffer window;		//!< window of raw samples
+		Preprocessor pre;			//!< causal preprocessing state (streaming)
+		GravityFilter lowPass;		//!< low-pass filter of the windows (batch)
+		IncrementalScorer* scorer;	//!< running sums (INCREMENTAL scoring only)
+		rmat gravity;				//!< gravity component of the last window
+		rmat body;					//!< body acc. component of the last window
+		vector<float> possibilities;		//!< models possibilities
+		vector<float> past_possibilities;	//!< models previous possibilities
+
+		//! constructor
+		Stream(boost::shared_ptr<const ModelSet> m, bool incremental);
+
+		//! move the state to a new set of models (the warm window is kept)
+		void rebind(boost::shared_ptr<const ModelSet> m);
+
+		//! destructor
+		~Stream();
+};
+
 //!\test test all
 
 //! class "Classifier" for offline and online recognition of HMP
 class Classifier
 {
+	friend class CompareJob;
+
 	private:
-		//! compute (trial)point-to-(model)point Mahalanobis distance
-		float mahalanobisDist(int index,mat &trial,mat &model,cube &variance);
+		WorkerPool* pool;		//!< persistent worker threads (NULL: serial)
+		vector<double> partial;	//!< partial sums of the threads (split points)
+		boost::mutex partialLock;	//!< lock of the partial sums
+		boost::mutex statsLock;	//!< lock of the early exit counters
+		boost::thread* reloader;			//!< background reloads (NULL: none)
+		boost::mutex reloadLock;			//!< lock of the reload requests
+		boost::condition_variable reloadWake;	//!< signals a request (or stop)
+		bool reloadRequested;	//!< flag --> reload the set as soon as possible
+		bool stopReload;		//!< flag --> terminate the background reloads
+		int watchPeriod;		//!< period of the dataset files check (ms, 0: off)
 
 		//! compute the overall distance between the trial and one model
-		float compareOne(mat &Tgravity, mat &Tbody, DYmodel &MODEL);
+		float compareOne(const rmat &Tgravity, const rmat &Tbody,
+						 const DYmodel &MODEL, int &scored);
+
+		//! update the early exit counters with the points scored per model
+		void countScored(const ModelSet &set, int* scored);
+
+		//! compute the possibilities from the trial-to-model distances
+		void computePossibilities(const ModelSet &set, float* distance,
+								  vector<float> &possibilities);
+
+		//! main loop of the background reloads
+		void reloadLoop();
+
+		//! start the background reloads (if not running yet)
+		void startReloader();
+
+		//! stop and join the background reloads
+		void stopReloader();
+
+		//! initialize the classifier variables (models excluded)
+		void init(Device* dev, Publisher* p, int nT);
 
 		//! test one file (off-line)
 		void singleTest(string testFile, string resultFile);
 
+		//! compare streaming and per-window preprocessing on one file (off-line)
+		void streamingTest(string testFile, string reportFile);
+
+		//! compare double and single precision results of one trial (off-line)
+		void precisionTest(string doubleFile, string floatFile);
+
+		//! compare incremental and batch scoring on one file (off-line)
+		void incrementalTest(string testFile, string reportFile);
+
 	protected:
 		//! publish the static information (loaded HMPs)
 		void publishStatic();
 
+		//! publish the static information of a set on a given publisher
+		void publishStatic(const ModelSet &set, Publisher* target);
+
+		//! publish the dynamic information of a set on a given publisher
+		void publishDynamic(const ModelSet &set, const vector<float> &possibilities,
+							Publisher* target, int sample);
+
 	public:
-		string datasetFolder;   //!< folder containing the models
+		//! scoring modes of the windows
+		enum ScoringMode
+		{
+			BATCH,				//!< every window is scored from scratch
+			INCREMENTAL			//!< running sums over causal features
+		};
+
+		string datasetFolder;   //!< folder containing the models (set adopted by
+								//!< the classifying thread: reloads leave it)
         Device* driver;         //!< driver for the device used for the dataset collection
         Publisher* pub;         //!< interface for the publishing middleware
-		int nbM;			    //!< number of considered models
-		vector<DYmodel> set;	//!< set of considered models
-		int window_size;		//!< size of the largest stored model
+		int nbM;			    //!< number of considered models (adopted set)
+		boost::shared_ptr<const ModelSet> models;	//!< (shared) set of models
+								//!< (swapped atomically: read it via currentSet)
+		int window_size;		//!< size of the largest stored model (adopted set)
+		GravityFilter lowPass;	//!< low-pass filter of the windows analyzed
+								//!< by the classifier thread (designed once)
+		bool streaming;			//!< flag --> causal (sample-by-sample) preprocessing
+		ScoringMode scoring;	//!< scoring mode (INCREMENTAL implies streaming)
+		int nbThreads;			//!< number of threads used by compareAll
+		int hopSize;			//!< number of samples between two evaluated windows
+		bool earlyExit;			//!< flag --> stop scoring a model past its threshold
+		unsigned long nbCompared;		//!< number of trial-to-model comparisons
+		unsigned long nbShortCircuits;	//!< number of comparisons stopped early
+		unsigned long pointsScored;		//!< number of model points scored
+		unsigned long pointsTotal;		//!< number of model points compared
 
 		//! constructor
-		Classifier(string dF, Device* dev, Publisher* p);
+		Classifier(string dF, Device* dev, Publisher* p, int nT = 1);
+
+		//! constructor with a shared set of models
+		Classifier(boost::shared_ptr<const ModelSet> m, Device* dev, Publisher* p,
+				   int nT = 1);
 
 		//! print set information
 		void printSetInfo();
@@ -97,31 +298,100 @@ class Classifier
 		//! set all the classifier variables and load the models
 		void buildSet(string dF, Device* dev, Publisher* p);
 
+		//! get the current set of models (never blocked by a reload)
+		//! @return		shared set of models
+		boost::shared_ptr<const ModelSet> currentSet() const
+		{
+			return boost::atomic_load(&models);
+		}
+
+		//! replace the set of models (the streams move to it between windows)
+		void swapSet(boost::shared_ptr<const ModelSet> m);
+
+		//! replace the set of models and describe it (classifying thread only)
+		void adoptSet(boost::shared_ptr<const ModelSet> m);
+
+		//! load the current dataset again and swap the new set in
+		bool reload();
+
+		//! ask for a reload in the background (the call does not wait)
+		void requestReload();
+
+		//! check the dataset files periodically and reload them when changed
+		void watch(int periodMs);
+
 		//! create a window of samples
-		void createWindow(mat &one_sample, mat &window, int &N, int &numWritten);
+		void createWindow(mat &one_sample, SampleBuffer &window, int &numWritten);
 
 		//! get gravity and body acc. components of the window
-		void analyzeWindow(mat &window, mat &gravity, mat &body);
+		void analyzeWindow(const rmat &window, rmat &gravity, rmat &body);
+
+		//! get gravity and body acc. components of the window (given filter)
+		void analyzeWindow(const rmat &window, rmat &gravity, rmat &body,
+						   GravityFilter &filter);
 
 		//! compute the matching possibility of all the models
-		void compareAll(mat &gravity,mat &body, vector<float> &possibilities);
+		void compareAll(const rmat &gravity, const rmat &body,
+						vector<float> &possibilities);
+
+		//! compute the matching possibility of all the models of a given set
+		void compareAll(const ModelSet &set, const rmat &gravity, const rmat &body,
+						vector<float> &possibilities);
+
+		//! get the matching possibility of all the models (incremental scoring)
+		void compareAll(const ModelSet &set, IncrementalScorer &scorer,
+						vector<float> &possibilities);
+
+		//! add one sample to a stream and classify its last window
+		bool classifySample(const mat &one_sample, Stream &s);
 
 		//! validate one model with given validation trials
 		void validateModel(string model, string dataset, int numTrials);
 
+		//! reset the early exit counters
+		void resetCounters();
+
+		//! print the early exit counters
+		void printCounters();
+
+		//! compare streaming and per-window preprocessing on validation trials
+		void compareStreaming(string model, string dataset, int numTrials);
+
+		//! compare double and single precision results on validation trials
+		void comparePrecision(string model, string dataset, int numTrials);
+
+		//! compare incremental and batch scoring on validation trials
+		void compareIncremental(string model, string dataset, int numTrials);
+
+		//! compare multi-wearer (server) and single-stream classification
+		void compareServer(string model, string dataset, int numTrials);
+
+		//! measure the per-point cost of the Mahalanobis distance
+		void benchmarkPoint(int repetitions);
+
+		//! compare the scalar and the interleaved (SIMD) gravity filters
+		void benchmarkFilter(int repetitions);
+
 		//! test one recorded file
 		void longTest(string testFile);
 
 		//! publish the dynamic information (recognition results)
 		void publishDynamic(vector<float> &possibilities);
 
+		//! publish the dynamic information on a given publisher
+		void publishDynamic(vector<float> &possibilities, Publisher* target);
+
+		//! publish the dynamic information of one stream on a given publisher
+		void publishDynamic(Stream &s, Publisher* target);
+
 		//! classify real-time raw acceleration samples acquired via USB
 		//void onlineTest(char* port);
 
 		//! destructor
 		~Classifier()
 		{
-			set.clear();
+			stopReloader();
+			delete pool;
 			//DEBUG:cout<<endl <<"Destroying Classifier object" <<endl;
 		}
 };
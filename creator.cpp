@@ -8,6 +8,7 @@
 
 #include <fstream>
 
+#include "classifier.hpp"
 #include "creator.hpp"
 #include "libs/GMM+GMR/gmr.h"
 
@@ -43,6 +44,7 @@ Creator::Creator(string dF, Device* dev)
     //DEBUG:cout<<"modelling dataset in folder: " <<datasetFolder <<endl;
     driver = dev;
     //DEBUG:driver->printInfo();
+    lowPass.configure(readFilterConfig(datasetFolder + "Filterconfig.txt"));
 }
 
 //! set dataset folder
@@ -51,6 +53,7 @@ void Creator::setDatasetFolder(string dF)
 {
 	datasetFolder = "./Models/" + dF + "/";
     //DEBUG:cout<<"modelling dataset in folder: " <<datasetFolder <<endl;
+    lowPass.configure(readFilterConfig(datasetFolder + "Filterconfig.txt"));
 }
 
 //! concatenate the trials of the modelling dataset along the three axes
@@ -89,17 +92,14 @@ void Creator::getFeatures(string name, int nTr, mat &totGravity, mat &totBody)
             createSet(actualSample, set);
         }
         
-		// reduce the noise on the sets by median filtering
+		// reduce the noise on the sets by median filtering, then separate
+		// gravity and body acc. by ChebyshevI low-pass filtering
+		// (fused kernel shared with Classifier, one axis per column)
 		int size = 3;
-		mat clean_set = set.t();
-		medianFilter(clean_set, size);
-		clean_set = clean_set.t();
-
-		// separate gravity and body acc. by Chebyshev II low-pass filtering
-		mat tempgr = clean_set.t();
-		gravity = ChebyshevFilter(tempgr);
-		gravity = gravity.t();
-		body = clean_set - gravity;
+		gravity.set_size(set.n_rows, set.n_cols);
+		body.set_size(set.n_rows, set.n_cols);
+		extractFeatures(set.memptr(), set.n_rows, 1, set.n_rows, size, lowPass,
+						gravity.memptr(), body.memptr());
 
 		// create the datasets
 		mat time = createInterval(1, gravity.n_rows);
@@ -198,6 +198,10 @@ void Creator::generateModel(STmodel &motion)
 		gb.saveRegressionResult(MuBo.c_str(),SBo.c_str(),*inData,outData,outSigma);
 		cout <<"done" <<endl;
 	}
+
+	// write the binary model (mapped by the classifier, no parsing)
+	DYmodel binary;
+	binary.convert(datasetFolder + motion.name);
 }
 
 //! create the models of all motion primitives
@@ -60,6 +60,8 @@ class Creator
 	public:                
 		string datasetFolder;		//!< folder containing the modelling dataset
         Device* driver;             //!< driver for the device used for the dataset collection
+		GravityFilter lowPass;		//!< low-pass filter of the trials (designed
+									//!< once per dataset)
 
 		//! constructor
 		Creator(string dF, Device* dev);
@@ -0,0 +1,220 @@
+//===============================================================================//
+// Name			: deadband.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Change-driven publishing policy (deadbands and heartbeat)
+//===============================================================================//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "deadband.hpp"
+
+using namespace boost::posix_time;
+
+//! constructor
+//! @param[in] eps		deadband of the keys without their own
+//! @param[in] hbMs		max silence of a key (ms, <= 0: no heartbeat)
+ChangePolicy::ChangePolicy(double eps, int hbMs)
+{
+	defaultDeadband = eps;
+	heartbeatMs = hbMs;
+	emitted = 0;
+	suppressed = 0;
+}
+
+//! set the deadband of a key
+//! @param[in] &key		reference to the key
+//! @param[in] eps		deadband of the key (0: any change is published)
+void ChangePolicy::setDeadband(const string &key, double eps)
+{
+	deadbands[key] = eps;
+}
+
+//! get the deadband of a key
+//! @param[in] &key		reference to the key
+//! @return				deadband of the key (default if not set)
+double ChangePolicy::deadband(const string &key) const
+{
+	map<string, double>::const_iterator it = deadbands.find(key);
+	return (it == deadbands.end()) ? defaultDeadband : it->second;
+}
+
+//! check whether the heartbeat of a key is due
+//! @param[in] &key		reference to the key
+//! @return				true if the key has never been published or has been
+//!						silent for longer than the heartbeat
+bool ChangePolicy::heartbeatDue(const string &key) const
+{
+	map<string, Entry>::const_iterator it = entries.find(key);
+	if (it == entries.end())
+		return true;
+	if (heartbeatMs <= 0)
+		return false;
+	return (microsec_clock::local_time() - it->second.last).total_milliseconds()
+			>= heartbeatMs;
+}
+
+//! record a publication of a key
+//! @param[in,out] &e	reference to the entry of the key
+//! @param[in] numeric	flag --> the value is a number
+//! @param[in] number	published number
+//! @param[in] &text	reference to the published text (not a number)
+void ChangePolicy::record(Entry &e, bool numeric, double number, const string &text)
+{
+	e.numeric = numeric;
+	e.number = number;
+	if (numeric)
+		e.text.clear();
+	else
+		e.text = text;
+	e.last = microsec_clock::local_time();
+	emitted++;
+}
+
+//! decide whether a number is to be published (recorded if so)
+//! @param[in] &key		reference to the key
+//! @param[in] value	number to be published
+//! @return				true if the number is to be published
+bool ChangePolicy::accept(const string &key, double value)
+{
+	map<string, Entry>::iterator it = entries.find(key);
+	if (it != entries.end() && it->second.numeric
+		&& fabs(value - it->second.number) <= deadband(key) && !heartbeatDue(key))
+	{
+		suppressed++;
+		return false;
+	}
+	record(entries[key], true, value, "");
+	return true;
+}
+
+//! decide whether a value is to be published (recorded if so)
+//! (numbers are compared with the deadband of the key, texts for equality)
+//! @param[in] &key		reference to the key
+//! @param[in] &value	reference to the value to be published
+//! @return				true if the value is to be published
+bool ChangePolicy::accept(const string &key, const string &value)
+{
+	char* end;
+	double number = strtod(value.c_str(), &end);
+	if (!value.empty() && *end == '\0')
+		return accept(key, number);
+
+	map<string, Entry>::iterator it = entries.find(key);
+	if (it != entries.end() && !it->second.numeric && it->second.text == value
+		&& !heartbeatDue(key))
+	{
+		suppressed++;
+		return false;
+	}
+	record(entries[key], false, 0, value);
+	return true;
+}
+
+//! record a number published anyway (transitions)
+//! @param[in] &key		reference to the key
+//! @param[in] value	published number
+void ChangePolicy::emit(const string &key, double value)
+{
+	record(entries[key], true, value, "");
+}
+
+//! record a value published anyway (transitions)
+//! @param[in] &key		reference to the key
+//! @param[in] &value	reference to the published value
+void ChangePolicy::emit(const string &key, const string &value)
+{
+	record(entries[key], false, 0, value);
+}
+
+//! forget the last published values (next values are published)
+void ChangePolicy::reset()
+{
+	entries.clear();
+}
+
+//! print the numbers of published and suppressed values
+void ChangePolicy::printCounters()
+{
+	unsigned long total = emitted + suppressed;
+	cout<<"Published values: " <<emitted <<", suppressed: " <<suppressed;
+	if (total > 0)
+		cout<<" (" <<100.0 * suppressed / total <<"% saved)";
+	cout<<endl;
+}
+
+//! constructor
+//! (call to Publisher::Publisher constructor)
+//! @param[in] *p		wrapped publisher (not owned)
+//! @param[in] eps		deadband of the possibilities, "other" and "entropy"
+//! @param[in] hbMs		max silence of the results (ms, <= 0: no heartbeat)
+DeadbandPublisher::DeadbandPublisher(Publisher* p, double eps, int hbMs)
+	: Publisher(p->name), target(p), policy(eps, hbMs)
+{
+	published = false;
+	lastBest = -1;
+	lastOther = 0;
+	lastEntropy = 0;
+}
+
+//! publish information (if changed beyond the deadband of the key)
+//! @param[in] key     key of the information to be published
+//! @param[in] value   value of the information to be published
+void DeadbandPublisher::publish(const string key, const string value)
+{
+	if (policy.accept(key, value))
+		target->publish(key, value);
+}
+
+//! publish the static information (always forwarded)
+//! (the next record is published: the models may have changed)
+//! @param[in] &m      reference to the static information
+void DeadbandPublisher::publishModels(const ModelsRecord &m)
+{
+	published = false;
+	policy.emitted++;
+	target->publishModels(m);
+}
+
+//! decide whether a record is to be published
+//! @param[in] &r      reference to the recognition results
+//! @return			   true on a transition of the highest model, on a change
+//!					   beyond a deadband or when the heartbeat is due
+bool DeadbandPublisher::changed(const ResultRecord &r) const
+{
+	if (!published || r.best != lastBest || r.nbM != (int) lastPoss.size())
+		return true;
+	double eps = policy.deadband("possibilities");
+	for (int i = 0; i < r.nbM; i++)
+		if (fabs(r.possibilities[i] - lastPoss[i]) > eps)
+			return true;
+	if (fabs(r.other() - lastOther) > policy.deadband("other"))
+		return true;
+	if (fabs(r.entropy() - lastEntropy) > policy.deadband("entropy"))
+		return true;
+	return (policy.heartbeatMs > 0
+			&& (microsec_clock::local_time() - last).total_milliseconds()
+				>= policy.heartbeatMs);
+}
+
+//! publish the dynamic information (if changed)
+//! @param[in] &r      reference to the recognition results
+void DeadbandPublisher::publishResults(const ResultRecord &r)
+{
+	if (!changed(r))
+	{
+		policy.suppress();
+		return;
+	}
+	published = true;
+	lastBest = r.best;
+	lastPoss.assign(r.possibilities, r.possibilities + r.nbM);
+	lastOther = r.other();
+	lastEntropy = r.entropy();
+	last = microsec_clock::local_time();
+	policy.emitted++;
+	target->publishResults(r);
+}
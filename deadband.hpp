@@ -0,0 +1,134 @@
+//===============================================================================//
+// Name			: deadband.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Change-driven publishing policy (deadbands and heartbeat)
+//===============================================================================//
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "publisher.hpp"
+
+using namespace std;
+
+#ifndef DEADBAND_HPP_
+#define DEADBAND_HPP_
+
+//! class "ChangePolicy", change-driven publishing policy
+//! (a value is published only if it moved beyond the deadband of its key
+//! since its last publication, or if the key has been silent for longer
+//! than the heartbeat; the other values are suppressed and counted)
+class ChangePolicy
+{
+	private:
+		//! record "Entry", last published value of a key
+		struct Entry
+		{
+			bool numeric;					//!< flag --> the value is a number
+			double number;					//!< last published number
+			string text;					//!< last published text (not a number)
+			boost::posix_time::ptime last;	//!< time of the last publication
+		};
+
+		map<string, Entry> entries;		//!< last published values (per key)
+		map<string, double> deadbands;	//!< deadbands of the keys (per key)
+
+		//! record a publication of a key
+		void record(Entry &e, bool numeric, double number, const string &text);
+
+	public:
+		double defaultDeadband;		//!< deadband of the keys without their own
+		int heartbeatMs;			//!< max silence of a key (ms, <= 0: none)
+		unsigned long emitted;		//!< number of published values
+		unsigned long suppressed;	//!< number of suppressed values
+
+		//! constructor
+		ChangePolicy(double eps = 0.01, int hbMs = 1000);
+
+		//! set the deadband of a key
+		void setDeadband(const string &key, double eps);
+
+		//! get the deadband of a key
+		double deadband(const string &key) const;
+
+		//! check whether the heartbeat of a key is due
+		bool heartbeatDue(const string &key) const;
+
+		//! decide whether a number is to be published (recorded if so)
+		bool accept(const string &key, double value);
+
+		//! decide whether a value is to be published (recorded if so)
+		bool accept(const string &key, const string &value);
+
+		//! record a value published anyway (transitions)
+		void emit(const string &key, double value);
+
+		//! record a value published anyway (transitions)
+		void emit(const string &key, const string &value);
+
+		//! count a suppressed value (decided by the caller)
+		void suppress()
+		{
+			suppressed++;
+		}
+
+		//! forget the last published values (next values are published)
+		void reset();
+
+		//! print the numbers of published and suppressed values
+		void printCounters();
+
+		//! destructor
+		~ChangePolicy()
+		{
+			//DEBUG:cout<<endl <<"Destroying ChangePolicy object" <<endl;
+		}
+};
+
+//! derivate class "DeadbandPublisher", change-driven interface to a publisher
+//! (forwards to the wrapped publisher the recognition results that changed:
+//! transitions of the highest model, possibilities, "other" or "entropy"
+//! beyond their deadbands, plus a heartbeat; the static information and the
+//! string values that changed are always forwarded)
+class DeadbandPublisher: public Publisher
+{
+	private:
+		Publisher* target;			//!< wrapped publisher
+		bool published;				//!< flag --> a record has been published
+		int lastBest;				//!< highest model of the last record
+		vector<float> lastPoss;		//!< possibilities of the last record
+		float lastOther;			//!< "other" of the last record
+		float lastEntropy;			//!< "entropy" of the last record
+		boost::posix_time::ptime last;	//!< time of the last record
+
+		//! decide whether a record is to be published
+		bool changed(const ResultRecord &r) const;
+
+	public:
+		ChangePolicy policy;		//!< deadbands, heartbeat and counters
+
+		//! constructor
+		DeadbandPublisher(Publisher* p, double eps = 0.01, int hbMs = 1000);
+
+		//! publish information (if changed beyond the deadband of the key)
+		void publish(const string key, const string value);
+
+		//! publish the static information (always forwarded)
+		void publishModels(const ModelsRecord &m);
+
+		//! publish the dynamic information (if changed)
+		void publishResults(const ResultRecord &r);
+
+		//! destructor
+		~DeadbandPublisher()
+		{
+			//DEBUG:cout<<endl <<"Destroying DeadbandPublisher object" <<endl;
+		}
+};
+
+#endif
@@ -0,0 +1,123 @@
+//===============================================================================//
+// Name			: filtercheck.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Check of the interleaved (SIMD) gravity filter of DspFilters
+//===============================================================================//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "libs/DspFilters/ChebyshevI.h"
+#include "libs/DspFilters/Interleaved.h"
+
+using namespace std;
+
+//! scalar reference filter (the gravity filter of the 32 Hz devices)
+typedef Dsp::SimpleFilter<Dsp::ChebyshevI::LowPass<5>,3> ScalarFilter;
+
+//! number of samples of the synthetic signal
+static const int NB_SAMPLES = 1000;
+
+//! synthetic acceleration signal (slow component plus fast noise)
+//! @param[in] i			index of the sample
+//! @param[in] axis		index of the axis
+//! @return				value of the sample
+template <typename Sample>
+Sample signal(int i, int axis)
+{
+	return (Sample) (1000 * sin(0.01 * i + axis) + 200 * sin(1.3 * i * (axis + 1)));
+}
+
+//! scalar output on the synthetic signal (one vector per axis)
+//! @param[in] &output	reference to the output vectors (3, resized)
+template <typename Sample>
+void reference(vector<double>* output)
+{
+	double* axes[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		output[axis].resize(NB_SAMPLES);
+		for (int i = 0; i < NB_SAMPLES; i++)
+			output[axis][i] = (double) signal<Sample>(i, axis);
+		axes[axis] = &output[axis][0];
+	}
+	ScalarFilter scalar;
+	scalar.setup(2, 32, 0.25, 0.001);
+	scalar.process(NB_SAMPLES, axes);
+}
+
+//! filter the synthetic signal with an interleaved cascade placed at a given
+//! distance from a 32-byte boundary (filters allocated with new are only
+//! 16-byte aligned: the cascade must not depend on a stronger alignment)
+//! @param[in] offset		distance from a 32-byte boundary (bytes, multiple of 8)
+//! @param[in] &reference	reference to the scalar output (one vector per axis)
+//! @param[in] rows			flag --> 3xN layout (Nx3 otherwise)
+//! @return					largest difference from the scalar output
+template <typename Sample>
+double check(int offset, const vector<double>* reference, bool rows)
+{
+	ScalarFilter design;
+	design.setup(2, 32, 0.25, 0.001);
+
+	// cascade on the heap, at the requested distance from a 32-byte boundary
+	vector<char> storage(sizeof(Dsp::InterleavedCascade) + 64);
+	size_t start = (32 - (size_t) &storage[0] % 32) % 32 + offset;
+	Dsp::InterleavedCascade* lanes = new (&storage[start]) Dsp::InterleavedCascade;
+	lanes->setup(design);
+
+	// synthetic signal (same as the reference), filtered in place
+	int sampleStride = rows ? 3 : 1;
+	int axisStride = rows ? 1 : NB_SAMPLES;
+	vector<Sample> data(3 * NB_SAMPLES);
+	for (int i = 0; i < NB_SAMPLES; i++)
+		for (int axis = 0; axis < 3; axis++)
+			data[i * sampleStride + axis * axisStride] = signal<Sample>(i, axis);
+	lanes->process(NB_SAMPLES, &data[0], 3, sampleStride, axisStride);
+	lanes->~InterleavedCascade();
+
+	// (double: bit-identical; float: one rounding of the double output)
+	double largest = 0;
+	for (int i = 0; i < NB_SAMPLES; i++)
+		for (int axis = 0; axis < 3; axis++)
+		{
+			Sample expected = (Sample) reference[axis][i];
+			double d = fabs((double) data[i * sampleStride + axis * axisStride]
+							- (double) expected);
+			largest = (d > largest) ? d : largest;
+		}
+
+	return largest;
+}
+
+//! compare the interleaved cascade with the scalar filter
+//! (heap placements at every 8-byte offset, both layouts, float and double)
+//! Usage: ./filtercheck (exit status 1 if any output differs)
+int main()
+{
+	// scalar references, in double precision on the double and float signals
+	vector<double> doubleReference[3];
+	vector<double> floatReference[3];
+	reference<double>(doubleReference);
+	reference<float>(floatReference);
+
+	cout<<"Interleaved cascade (" <<Dsp::InterleavedCascade::instructionSet()
+		<<") vs. scalar filter:" <<endl;
+	bool passed = true;
+	for (int offset = 0; offset < 32; offset += 8)
+		for (int rows = 0; rows < 2; rows++)
+		{
+			double d = check<double>(offset, doubleReference, rows == 1);
+			double f = check<float>(offset, floatReference, rows == 1);
+			cout<<"offset " <<offset <<(rows ? ", 3xN" : ", Nx3")
+				<<": double " <<d <<", float " <<f <<endl;
+			passed = passed && (d == 0) && (f == 0);
+		}
+	cout<<(passed ? "PASSED" : "FAILED") <<endl;
+
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+//===============================================================================//
+// Name			: hmpmonitor.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Sample consumer of the shared-memory ring of HMPdetector
+//===============================================================================//
+
+#include <cstdlib>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "shmring.hpp"
+
+//! print the recognition results published in a shared-memory ring
+//! (one line per record: sample, highest model, possibility, entropy and
+//! latency from the publication)
+//! Usage: ./hmpmonitor [ring] (default: /hmpdetector)
+int main(int argc, char* argv[])
+{
+	string ring = (argc > 1) ? argv[1] : SHM_RING_NAME;
+	ShmRingReader reader;
+	while (!reader.open(ring))
+	{
+		cout<<"Waiting for the shared-memory ring: " <<ring <<endl;
+		sleep(1);
+	}
+	cout<<"Attached to the shared-memory ring: " <<ring <<endl;
+
+	vector<string> models;
+	uint64_t namesSeq = 1;		// (odd: no names table read yet)
+	unsigned long lost = 0;
+	while (true)
+	{
+		const ShmRecord* r = reader.read();
+		if (r == NULL)
+		{
+			// (short poll: a record is seen within tens of microseconds)
+			usleep(20);
+			continue;
+		}
+		if (reader.lost != lost)
+		{
+			cout<<"(" <<reader.lost - lost <<" records lost)" <<endl;
+			lost = reader.lost;
+		}
+
+		// (the names table is rewritten when the models are reloaded)
+		uint64_t version = reader.namesVersion();
+		if (version != namesSeq && reader.names(models))
+			namesSeq = version;
+		string highest = "NONE";
+		if (r->best != -1 && r->best < (int) models.size())
+			highest = models[r->best];
+		float possibility = (r->best == -1) ? 0 : r->possibilities[r->best];
+		double latency = (shmTimestamp() - r->timestamp) / 1000.0;
+		cout<<r->sample <<"\t" <<highest <<"\t" <<possibility <<"\t"
+			<<r->entropy <<"\t" <<latency <<" us" <<endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,291 @@
+/*******************************************************************************
+
+Interleaved cascade for tri-axial data, built on
+"A Collection of Useful C++ Classes for Digital Signal Processing"
+ By Vinnie Falco (see Biquad.h for the license)
+
+*******************************************************************************/
+
+#include "Common.h"
+#include "Interleaved.h"
+
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DSPFILTERS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace Dsp {
+
+namespace {
+
+// samples gathered per block (lane buffer on the stack)
+const int Block = 64;
+
+// instruction sets available for the cascade
+enum { Portable, SSE2, AVX };
+
+// detect the best instruction set supported by the host
+int detectLevel ()
+{
+#ifdef DSPFILTERS_X86_SIMD
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx"))
+    return AVX;
+  if (__builtin_cpu_supports ("sse2"))
+    return SSE2;
+#endif
+  return Portable;
+}
+
+// instruction set of the host, detected once (the initialisation of a local
+// static is thread-safe: the cascades run on many threads at once)
+int simdLevel ()
+{
+  static const int level = detectLevel ();
+  return level;
+}
+
+// Direct Form II on every lane, same operations (and order) as
+// DirectFormII::process1 in State.h:
+//   w   = in - a1*v1 - a2*v2 + vsa
+//   out = b0*w + b1*v1 + b2*v2
+void cascadePortable (int stages, const double (*c)[5],
+                      double (*v1)[InterleavedCascade::Lanes],
+                      double (*v2)[InterleavedCascade::Lanes],
+                      double* buf, int count, double& vsa)
+{
+  const int L = InterleavedCascade::Lanes;
+  for (int i = 0; i < count; ++i, buf += L)
+  {
+    vsa = -vsa;
+    for (int s = 0; s < stages; ++s)
+    {
+      const double add = (s == 0) ? vsa : 0;
+      for (int k = 0; k < L; ++k)
+      {
+        double w   = buf[k] - c[s][3]*v1[s][k] - c[s][4]*v2[s][k] + add;
+        double out =          c[s][0]*w        + c[s][1]*v1[s][k] + c[s][2]*v2[s][k];
+        v2[s][k] = v1[s][k];
+        v1[s][k] = w;
+        buf[k] = out;
+      }
+    }
+  }
+}
+
+#ifdef DSPFILTERS_X86_SIMD
+// 4 lanes in one AVX register per state (the state of the cascade is
+// loaded once per block and may be unaligned; the lane buffer is aligned)
+__attribute__((target("avx")))
+void cascadeAVX (int stages, const double (*c)[5],
+                 double (*v1)[InterleavedCascade::Lanes],
+                 double (*v2)[InterleavedCascade::Lanes],
+                 double* buf, int count, double& vsa)
+{
+  const int L = InterleavedCascade::Lanes;
+  __m256d s1[InterleavedCascade::MaxStages];
+  __m256d s2[InterleavedCascade::MaxStages];
+  for (int s = 0; s < stages; ++s)
+  {
+    s1[s] = _mm256_loadu_pd (v1[s]);
+    s2[s] = _mm256_loadu_pd (v2[s]);
+  }
+  const __m256d zero = _mm256_setzero_pd ();
+  for (int i = 0; i < count; ++i, buf += L)
+  {
+    vsa = -vsa;
+    __m256d x = _mm256_load_pd (buf);
+    for (int s = 0; s < stages; ++s)
+    {
+      const __m256d add = (s == 0) ? _mm256_set1_pd (vsa) : zero;
+      __m256d w = _mm256_sub_pd (x, _mm256_mul_pd (_mm256_set1_pd (c[s][3]), s1[s]));
+      w = _mm256_sub_pd (w, _mm256_mul_pd (_mm256_set1_pd (c[s][4]), s2[s]));
+      w = _mm256_add_pd (w, add);
+      __m256d out = _mm256_mul_pd (_mm256_set1_pd (c[s][0]), w);
+      out = _mm256_add_pd (out, _mm256_mul_pd (_mm256_set1_pd (c[s][1]), s1[s]));
+      out = _mm256_add_pd (out, _mm256_mul_pd (_mm256_set1_pd (c[s][2]), s2[s]));
+      s2[s] = s1[s];
+      s1[s] = w;
+      x = out;
+    }
+    _mm256_store_pd (buf, x);
+  }
+  for (int s = 0; s < stages; ++s)
+  {
+    _mm256_storeu_pd (v1[s], s1[s]);
+    _mm256_storeu_pd (v2[s], s2[s]);
+  }
+}
+
+// 4 lanes in two SSE2 registers per state (x,y and z,padding)
+__attribute__((target("sse2")))
+void cascadeSSE2 (int stages, const double (*c)[5],
+                  double (*v1)[InterleavedCascade::Lanes],
+                  double (*v2)[InterleavedCascade::Lanes],
+                  double* buf, int count, double& vsa)
+{
+  const int L = InterleavedCascade::Lanes;
+  __m128d s1[InterleavedCascade::MaxStages][2];
+  __m128d s2[InterleavedCascade::MaxStages][2];
+  for (int s = 0; s < stages; ++s)
+    for (int h = 0; h < 2; ++h)
+    {
+      s1[s][h] = _mm_loadu_pd (v1[s] + 2*h);
+      s2[s][h] = _mm_loadu_pd (v2[s] + 2*h);
+    }
+  const __m128d zero = _mm_setzero_pd ();
+  for (int i = 0; i < count; ++i, buf += L)
+  {
+    vsa = -vsa;
+    __m128d x[2] = { _mm_load_pd (buf), _mm_load_pd (buf + 2) };
+    for (int s = 0; s < stages; ++s)
+    {
+      const __m128d add = (s == 0) ? _mm_set1_pd (vsa) : zero;
+      const __m128d a1 = _mm_set1_pd (c[s][3]);
+      const __m128d a2 = _mm_set1_pd (c[s][4]);
+      const __m128d b0 = _mm_set1_pd (c[s][0]);
+      const __m128d b1 = _mm_set1_pd (c[s][1]);
+      const __m128d b2 = _mm_set1_pd (c[s][2]);
+      for (int h = 0; h < 2; ++h)
+      {
+        __m128d w = _mm_sub_pd (x[h], _mm_mul_pd (a1, s1[s][h]));
+        w = _mm_sub_pd (w, _mm_mul_pd (a2, s2[s][h]));
+        w = _mm_add_pd (w, add);
+        __m128d out = _mm_mul_pd (b0, w);
+        out = _mm_add_pd (out, _mm_mul_pd (b1, s1[s][h]));
+        out = _mm_add_pd (out, _mm_mul_pd (b2, s2[s][h]));
+        s2[s][h] = s1[s][h];
+        s1[s][h] = w;
+        x[h] = out;
+      }
+    }
+    _mm_store_pd (buf, x[0]);
+    _mm_store_pd (buf + 2, x[1]);
+  }
+  for (int s = 0; s < stages; ++s)
+    for (int h = 0; h < 2; ++h)
+    {
+      _mm_storeu_pd (v1[s] + 2*h, s1[s][h]);
+      _mm_storeu_pd (v2[s] + 2*h, s2[s][h]);
+    }
+}
+#endif
+
+}
+
+//------------------------------------------------------------------------------
+
+const char* InterleavedCascade::instructionSet ()
+{
+  switch (simdLevel ())
+  {
+    case AVX:
+      return "AVX";
+    case SSE2:
+      return "SSE2";
+  }
+  return "portable";
+}
+
+InterleavedCascade::InterleavedCascade ()
+  : m_numStages (0)
+  , m_vsa (anti_denormal_vsa)
+{
+  reset ();
+}
+
+void InterleavedCascade::setup (Cascade& cascade)
+{
+  m_numStages = cascade.getNumStages ();
+  if (m_numStages > MaxStages)
+    throw std::logic_error ("too many stages for InterleavedCascade");
+
+  for (int s = 0; s < m_numStages; ++s)
+  {
+    const Biquad& stage = cascade[s];
+    m_coeff[s][0] = stage.m_b0;
+    m_coeff[s][1] = stage.m_b1;
+    m_coeff[s][2] = stage.m_b2;
+    m_coeff[s][3] = stage.m_a1;
+    m_coeff[s][4] = stage.m_a2;
+  }
+  reset ();
+}
+
+// (the anti-denormal term keeps alternating, as in DenormalPrevention)
+void InterleavedCascade::reset ()
+{
+  for (int s = 0; s < MaxStages; ++s)
+    for (int k = 0; k < Lanes; ++k)
+    {
+      m_v1[s][k] = 0;
+      m_v2[s][k] = 0;
+    }
+}
+
+template <typename Sample>
+void InterleavedCascade::processBlock (int numSamples, Sample* dest, int channels,
+                                       int sampleStride, int channelStride)
+{
+  if (channels < 1 || channels > Lanes)
+    throw std::logic_error ("InterleavedCascade: 1 to 4 channels");
+
+  double buf[Block * Lanes] __attribute__((aligned(32)));
+  while (numSamples > 0)
+  {
+    const int count = (numSamples < Block) ? numSamples : Block;
+
+    // gather the channels into the lanes (padding lanes at 0)
+    for (int i = 0; i < count; ++i)
+    {
+      const Sample* in = dest + i*sampleStride;
+      int k = 0;
+      for (; k < channels; ++k)
+        buf[i*Lanes + k] = in[k*channelStride];
+      for (; k < Lanes; ++k)
+        buf[i*Lanes + k] = 0;
+    }
+
+    switch (simdLevel ())
+    {
+#ifdef DSPFILTERS_X86_SIMD
+      case AVX:
+        cascadeAVX (m_numStages, m_coeff, m_v1, m_v2, buf, count, m_vsa);
+        break;
+      case SSE2:
+        cascadeSSE2 (m_numStages, m_coeff, m_v1, m_v2, buf, count, m_vsa);
+        break;
+#endif
+      default:
+        cascadePortable (m_numStages, m_coeff, m_v1, m_v2, buf, count, m_vsa);
+        break;
+    }
+
+    // scatter the lanes back into the channels
+    for (int i = 0; i < count; ++i)
+    {
+      Sample* out = dest + i*sampleStride;
+      for (int k = 0; k < channels; ++k)
+        out[k*channelStride] = static_cast<Sample> (buf[i*Lanes + k]);
+    }
+
+    dest += count * sampleStride;
+    numSamples -= count;
+  }
+}
+
+void InterleavedCascade::process (int numSamples, float* dest, int channels,
+                                  int sampleStride, int channelStride)
+{
+  processBlock (numSamples, dest, channels, sampleStride, channelStride);
+}
+
+void InterleavedCascade::process (int numSamples, double* dest, int channels,
+                                  int sampleStride, int channelStride)
+{
+  processBlock (numSamples, dest, channels, sampleStride, channelStride);
+}
+
+}
@@ -0,0 +1,81 @@
+/*******************************************************************************
+
+Interleaved cascade for tri-axial data, built on
+"A Collection of Useful C++ Classes for Digital Signal Processing"
+ By Vinnie Falco (see Biquad.h for the license)
+
+*******************************************************************************/
+
+#ifndef DSPFILTERS_INTERLEAVED_H
+#define DSPFILTERS_INTERLEAVED_H
+
+#include "Common.h"
+#include "Cascade.h"
+
+namespace Dsp {
+
+/*
+ * Cascade of second order sections applied to up to 4 channels at once,
+ * for tri-axial sensors: x, y, z and a padding lane share one vector
+ * register per section state (Direct Form II, double precision).
+ *
+ * The coefficients are copied from a designed Cascade (ChebyshevI,
+ * Butterworth, ...): each channel gets exactly the arithmetic of
+ * SimpleFilter with DirectFormII state, anti-denormal term included,
+ * so the outputs are bit-identical to the scalar filters for double
+ * data. Float data is filtered in double through all the stages and
+ * rounded once, so it can differ from a scalar filter that rounds to
+ * float between stages.
+ *
+ * Instruction set chosen at run time: AVX (one register per state),
+ * SSE2 (two registers), portable code otherwise.
+ */
+class InterleavedCascade
+{
+public:
+  enum
+  {
+    Lanes = 4,
+    MaxStages = 8
+  };
+
+  InterleavedCascade ();
+
+  // Copy the coefficients of a designed cascade (the state is reset)
+  void setup (Cascade& cascade);
+
+  void reset ();
+
+  int getNumStages () const
+  {
+    return m_numStages;
+  }
+
+  // Name of the instruction set used on this host
+  static const char* instructionSet ();
+
+  // Process a block of samples of 1 to 4 channels, in place. Sample i of
+  // channel c is at dest[i*sampleStride + c*channelStride]: 3xN column-major
+  // matrices use (3, 1), Nx3 matrices use (1, N).
+  void process (int numSamples, float* dest, int channels,
+                int sampleStride, int channelStride);
+  void process (int numSamples, double* dest, int channels,
+                int sampleStride, int channelStride);
+
+private:
+  template <typename Sample>
+  void processBlock (int numSamples, Sample* dest, int channels,
+                     int sampleStride, int channelStride);
+
+  int m_numStages;
+  double m_vsa;                            // anti-denormal term (alternating)
+  double m_coeff[MaxStages][5];            // b0, b1, b2, a1, a2 (a0 = 1)
+  // (no alignment required: the owners are allocated with new, which only
+  // guarantees 16 bytes, so the state is loaded and stored unaligned)
+  double m_v1[MaxStages][Lanes];           // v[-1]
+  double m_v2[MaxStages][Lanes];           // v[-2]
+};
+
+}
+
+#endif
@@ -0,0 +1,444 @@
+//===============================================================================//
+// Name			: mahalanobis.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Batched 3-dimensional Mahalanobis distance kernel (SIMD)
+//===============================================================================//
+
+#include "mahalanobis.hpp"
+#include "triaxial.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HMP_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// arrays of the structure (offsets in units of stride)
+enum { MX, MY, MZ, S00, S01, S02, S11, S12, S22, NB_ARRAYS };
+
+// instruction sets available for the kernel
+enum { SCALAR, SSE2, AVX2 };
+
+//! detect the best instruction set supported by the host
+//! @return		instruction set usable by the kernel
+static int detect()
+{
+#ifdef HMP_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SSE2;
+#endif
+	return SCALAR;
+}
+
+//! instruction set of the host, detected once (the initialisation of a local
+//! static is thread-safe: the comparisons run on the worker threads)
+//! @return		instruction set used by the kernel
+static int simdLevel()
+{
+	static const int level = detect();
+	return level;
+}
+
+//! Mahalanobis distance of one trial point from model point j (scalar)
+//! @param[in] *d		pointer to the kernel arrays
+//! @param[in] stride	distance between two arrays of the structure
+//! @param[in] j		index of the model point
+//! @param[in] *t		pointer to the trial point (x,y,z)
+//! @return				Mahalanobis distance between the points
+static inline real_t distScalar(const real_t* d, int stride, int j, const real_t* t)
+{
+	Vec3<real_t> point(d[MX*stride + j], d[MY*stride + j], d[MZ*stride + j]);
+	SymMat3<real_t> S(d[S00*stride + j], d[S01*stride + j], d[S02*stride + j],
+					  d[S11*stride + j], d[S12*stride + j], d[S22*stride + j]);
+
+	return S.quadraticForm(Vec3<real_t>(t) - point);
+}
+
+#if defined(HMP_X86_SIMD) && defined(HMP_FLOAT32)
+//! sum the distances of trial points [j;n) from the model points (AVX2, float)
+//! (8 points per instruction; the partial sums are accumulated in double)
+__attribute__((target("avx2")))
+static double sumAVX2(const float* d, int stride, const float* trial, int n, int &j)
+{
+	const __m256i idx = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256 two = _mm256_set1_ps(2);
+	__m256d acc = _mm256_setzero_pd();
+	for (; j + 8 <= n; j += 8)
+	{
+		// trial points are stored one per column (x,y,z interleaved)
+		const float* t = trial + 3 * j;
+		__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(t, idx, 4),
+								  _mm256_loadu_ps(d + MX*stride + j));
+		__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(t + 1, idx, 4),
+								  _mm256_loadu_ps(d + MY*stride + j));
+		__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(t + 2, idx, 4),
+								  _mm256_loadu_ps(d + MZ*stride + j));
+		__m256 q = _mm256_mul_ps(_mm256_loadu_ps(d + S00*stride + j), _mm256_mul_ps(dx, dx));
+		q = _mm256_add_ps(q, _mm256_mul_ps(_mm256_loadu_ps(d + S11*stride + j), _mm256_mul_ps(dy, dy)));
+		q = _mm256_add_ps(q, _mm256_mul_ps(_mm256_loadu_ps(d + S22*stride + j), _mm256_mul_ps(dz, dz)));
+		__m256 c = _mm256_mul_ps(_mm256_loadu_ps(d + S01*stride + j), _mm256_mul_ps(dx, dy));
+		c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_loadu_ps(d + S02*stride + j), _mm256_mul_ps(dx, dz)));
+		c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_loadu_ps(d + S12*stride + j), _mm256_mul_ps(dy, dz)));
+		__m256 dist = _mm256_add_ps(q, _mm256_mul_ps(two, c));
+		acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(dist)));
+		acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(dist, 1)));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+//! sum the distances of trial points [j;n) from the model points (SSE2, float)
+//! (4 points per instruction; the partial sums are accumulated in double)
+__attribute__((target("sse2")))
+static double sumSSE2(const float* d, int stride, const float* trial, int n, int &j)
+{
+	const __m128 two = _mm_set1_ps(2);
+	__m128d acc = _mm_setzero_pd();
+	for (; j + 4 <= n; j += 4)
+	{
+		const float* t = trial + 3 * j;
+		__m128 dx = _mm_sub_ps(_mm_set_ps(t[9], t[6], t[3], t[0]), _mm_loadu_ps(d + MX*stride + j));
+		__m128 dy = _mm_sub_ps(_mm_set_ps(t[10], t[7], t[4], t[1]), _mm_loadu_ps(d + MY*stride + j));
+		__m128 dz = _mm_sub_ps(_mm_set_ps(t[11], t[8], t[5], t[2]), _mm_loadu_ps(d + MZ*stride + j));
+		__m128 q = _mm_mul_ps(_mm_loadu_ps(d + S00*stride + j), _mm_mul_ps(dx, dx));
+		q = _mm_add_ps(q, _mm_mul_ps(_mm_loadu_ps(d + S11*stride + j), _mm_mul_ps(dy, dy)));
+		q = _mm_add_ps(q, _mm_mul_ps(_mm_loadu_ps(d + S22*stride + j), _mm_mul_ps(dz, dz)));
+		__m128 c = _mm_mul_ps(_mm_loadu_ps(d + S01*stride + j), _mm_mul_ps(dx, dy));
+		c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(d + S02*stride + j), _mm_mul_ps(dx, dz)));
+		c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(d + S12*stride + j), _mm_mul_ps(dy, dz)));
+		__m128 dist = _mm_add_ps(q, _mm_mul_ps(two, c));
+		acc = _mm_add_pd(acc, _mm_cvtps_pd(dist));
+		acc = _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(dist, dist)));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, acc);
+
+	return lanes[0] + lanes[1];
+}
+
+//! distances of one trial point from the model points [j;size) (AVX2, float)
+__attribute__((target("avx2")))
+static void distancesAVX2(const float* d, int stride, int size, const float* p,
+							float* out, int &j)
+{
+	const __m256 px = _mm256_set1_ps(p[0]);
+	const __m256 py = _mm256_set1_ps(p[1]);
+	const __m256 pz = _mm256_set1_ps(p[2]);
+	const __m256 two = _mm256_set1_ps(2);
+	for (; j + 8 <= size; j += 8)
+	{
+		__m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(d + MX*stride + j));
+		__m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(d + MY*stride + j));
+		__m256 dz = _mm256_sub_ps(pz, _mm256_loadu_ps(d + MZ*stride + j));
+		__m256 q = _mm256_mul_ps(_mm256_loadu_ps(d + S00*stride + j), _mm256_mul_ps(dx, dx));
+		q = _mm256_add_ps(q, _mm256_mul_ps(_mm256_loadu_ps(d + S11*stride + j), _mm256_mul_ps(dy, dy)));
+		q = _mm256_add_ps(q, _mm256_mul_ps(_mm256_loadu_ps(d + S22*stride + j), _mm256_mul_ps(dz, dz)));
+		__m256 c = _mm256_mul_ps(_mm256_loadu_ps(d + S01*stride + j), _mm256_mul_ps(dx, dy));
+		c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_loadu_ps(d + S02*stride + j), _mm256_mul_ps(dx, dz)));
+		c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_loadu_ps(d + S12*stride + j), _mm256_mul_ps(dy, dz)));
+		_mm256_storeu_ps(out + j, _mm256_add_ps(q, _mm256_mul_ps(two, c)));
+	}
+}
+
+//! distances of one trial point from the model points [j;size) (SSE2, float)
+__attribute__((target("sse2")))
+static void distancesSSE2(const float* d, int stride, int size, const float* p,
+							float* out, int &j)
+{
+	const __m128 px = _mm_set1_ps(p[0]);
+	const __m128 py = _mm_set1_ps(p[1]);
+	const __m128 pz = _mm_set1_ps(p[2]);
+	const __m128 two = _mm_set1_ps(2);
+	for (; j + 4 <= size; j += 4)
+	{
+		__m128 dx = _mm_sub_ps(px, _mm_loadu_ps(d + MX*stride + j));
+		__m128 dy = _mm_sub_ps(py, _mm_loadu_ps(d + MY*stride + j));
+		__m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(d + MZ*stride + j));
+		__m128 q = _mm_mul_ps(_mm_loadu_ps(d + S00*stride + j), _mm_mul_ps(dx, dx));
+		q = _mm_add_ps(q, _mm_mul_ps(_mm_loadu_ps(d + S11*stride + j), _mm_mul_ps(dy, dy)));
+		q = _mm_add_ps(q, _mm_mul_ps(_mm_loadu_ps(d + S22*stride + j), _mm_mul_ps(dz, dz)));
+		__m128 c = _mm_mul_ps(_mm_loadu_ps(d + S01*stride + j), _mm_mul_ps(dx, dy));
+		c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(d + S02*stride + j), _mm_mul_ps(dx, dz)));
+		c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(d + S12*stride + j), _mm_mul_ps(dy, dz)));
+		_mm_storeu_ps(out + j, _mm_add_ps(q, _mm_mul_ps(two, c)));
+	}
+}
+#elif defined(HMP_X86_SIMD)
+//! sum the distances of trial points [j;n) from the model points (AVX2)
+__attribute__((target("avx2")))
+static double sumAVX2(const double* d, int stride, const double* trial, int n, int &j)
+{
+	const __m256i idx = _mm256_set_epi64x(9, 6, 3, 0);
+	const __m256d two = _mm256_set1_pd(2);
+	__m256d acc = _mm256_setzero_pd();
+	for (; j + 4 <= n; j += 4)
+	{
+		// trial points are stored one per column (x,y,z interleaved)
+		const double* t = trial + 3 * j;
+		__m256d dx = _mm256_sub_pd(_mm256_i64gather_pd(t, idx, 8),
+								   _mm256_loadu_pd(d + MX*stride + j));
+		__m256d dy = _mm256_sub_pd(_mm256_i64gather_pd(t + 1, idx, 8),
+								   _mm256_loadu_pd(d + MY*stride + j));
+		__m256d dz = _mm256_sub_pd(_mm256_i64gather_pd(t + 2, idx, 8),
+								   _mm256_loadu_pd(d + MZ*stride + j));
+		__m256d q = _mm256_mul_pd(_mm256_loadu_pd(d + S00*stride + j), _mm256_mul_pd(dx, dx));
+		q = _mm256_add_pd(q, _mm256_mul_pd(_mm256_loadu_pd(d + S11*stride + j), _mm256_mul_pd(dy, dy)));
+		q = _mm256_add_pd(q, _mm256_mul_pd(_mm256_loadu_pd(d + S22*stride + j), _mm256_mul_pd(dz, dz)));
+		__m256d c = _mm256_mul_pd(_mm256_loadu_pd(d + S01*stride + j), _mm256_mul_pd(dx, dy));
+		c = _mm256_add_pd(c, _mm256_mul_pd(_mm256_loadu_pd(d + S02*stride + j), _mm256_mul_pd(dx, dz)));
+		c = _mm256_add_pd(c, _mm256_mul_pd(_mm256_loadu_pd(d + S12*stride + j), _mm256_mul_pd(dy, dz)));
+		acc = _mm256_add_pd(acc, _mm256_add_pd(q, _mm256_mul_pd(two, c)));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+//! sum the distances of trial points [j;n) from the model points (SSE2)
+__attribute__((target("sse2")))
+static double sumSSE2(const double* d, int stride, const double* trial, int n, int &j)
+{
+	const __m128d two = _mm_set1_pd(2);
+	__m128d acc = _mm_setzero_pd();
+	for (; j + 2 <= n; j += 2)
+	{
+		const double* t = trial + 3 * j;
+		__m128d dx = _mm_sub_pd(_mm_set_pd(t[3], t[0]), _mm_loadu_pd(d + MX*stride + j));
+		__m128d dy = _mm_sub_pd(_mm_set_pd(t[4], t[1]), _mm_loadu_pd(d + MY*stride + j));
+		__m128d dz = _mm_sub_pd(_mm_set_pd(t[5], t[2]), _mm_loadu_pd(d + MZ*stride + j));
+		__m128d q = _mm_mul_pd(_mm_loadu_pd(d + S00*stride + j), _mm_mul_pd(dx, dx));
+		q = _mm_add_pd(q, _mm_mul_pd(_mm_loadu_pd(d + S11*stride + j), _mm_mul_pd(dy, dy)));
+		q = _mm_add_pd(q, _mm_mul_pd(_mm_loadu_pd(d + S22*stride + j), _mm_mul_pd(dz, dz)));
+		__m128d c = _mm_mul_pd(_mm_loadu_pd(d + S01*stride + j), _mm_mul_pd(dx, dy));
+		c = _mm_add_pd(c, _mm_mul_pd(_mm_loadu_pd(d + S02*stride + j), _mm_mul_pd(dx, dz)));
+		c = _mm_add_pd(c, _mm_mul_pd(_mm_loadu_pd(d + S12*stride + j), _mm_mul_pd(dy, dz)));
+		acc = _mm_add_pd(acc, _mm_add_pd(q, _mm_mul_pd(two, c)));
+	}
+	double lanes[2];
+	_mm_storeu_pd(lanes, acc);
+
+	return lanes[0] + lanes[1];
+}
+
+//! distances of one trial point from the model points [j;size) (AVX2)
+__attribute__((target("avx2")))
+static void distancesAVX2(const double* d, int stride, int size, const double* p,
+							double* out, int &j)
+{
+	const __m256d px = _mm256_set1_pd(p[0]);
+	const __m256d py = _mm256_set1_pd(p[1]);
+	const __m256d pz = _mm256_set1_pd(p[2]);
+	const __m256d two = _mm256_set1_pd(2);
+	for (; j + 4 <= size; j += 4)
+	{
+		__m256d dx = _mm256_sub_pd(px, _mm256_loadu_pd(d + MX*stride + j));
+		__m256d dy = _mm256_sub_pd(py, _mm256_loadu_pd(d + MY*stride + j));
+		__m256d dz = _mm256_sub_pd(pz, _mm256_loadu_pd(d + MZ*stride + j));
+		__m256d q = _mm256_mul_pd(_mm256_loadu_pd(d + S00*stride + j), _mm256_mul_pd(dx, dx));
+		q = _mm256_add_pd(q, _mm256_mul_pd(_mm256_loadu_pd(d + S11*stride + j), _mm256_mul_pd(dy, dy)));
+		q = _mm256_add_pd(q, _mm256_mul_pd(_mm256_loadu_pd(d + S22*stride + j), _mm256_mul_pd(dz, dz)));
+		__m256d c = _mm256_mul_pd(_mm256_loadu_pd(d + S01*stride + j), _mm256_mul_pd(dx, dy));
+		c = _mm256_add_pd(c, _mm256_mul_pd(_mm256_loadu_pd(d + S02*stride + j), _mm256_mul_pd(dx, dz)));
+		c = _mm256_add_pd(c, _mm256_mul_pd(_mm256_loadu_pd(d + S12*stride + j), _mm256_mul_pd(dy, dz)));
+		_mm256_storeu_pd(out + j, _mm256_add_pd(q, _mm256_mul_pd(two, c)));
+	}
+}
+
+//! distances of one trial point from the model points [j;size) (SSE2)
+__attribute__((target("sse2")))
+static void distancesSSE2(const double* d, int stride, int size, const double* p,
+							double* out, int &j)
+{
+	const __m128d px = _mm_set1_pd(p[0]);
+	const __m128d py = _mm_set1_pd(p[1]);
+	const __m128d pz = _mm_set1_pd(p[2]);
+	const __m128d two = _mm_set1_pd(2);
+	for (; j + 2 <= size; j += 2)
+	{
+		__m128d dx = _mm_sub_pd(px, _mm_loadu_pd(d + MX*stride + j));
+		__m128d dy = _mm_sub_pd(py, _mm_loadu_pd(d + MY*stride + j));
+		__m128d dz = _mm_sub_pd(pz, _mm_loadu_pd(d + MZ*stride + j));
+		__m128d q = _mm_mul_pd(_mm_loadu_pd(d + S00*stride + j), _mm_mul_pd(dx, dx));
+		q = _mm_add_pd(q, _mm_mul_pd(_mm_loadu_pd(d + S11*stride + j), _mm_mul_pd(dy, dy)));
+		q = _mm_add_pd(q, _mm_mul_pd(_mm_loadu_pd(d + S22*stride + j), _mm_mul_pd(dz, dz)));
+		__m128d c = _mm_mul_pd(_mm_loadu_pd(d + S01*stride + j), _mm_mul_pd(dx, dy));
+		c = _mm_add_pd(c, _mm_mul_pd(_mm_loadu_pd(d + S02*stride + j), _mm_mul_pd(dx, dz)));
+		c = _mm_add_pd(c, _mm_mul_pd(_mm_loadu_pd(d + S12*stride + j), _mm_mul_pd(dy, dz)));
+		_mm_storeu_pd(out + j, _mm_add_pd(q, _mm_mul_pd(two, c)));
+	}
+}
+#endif
+
+//! number of array elements between two arrays of the structure
+//! (multiple of 8, so that every array of a 64-byte aligned block is aligned)
+//! @param[in] size		number of model points
+//! @return				stride of the arrays
+int MahalanobisKernel::strideOf(int size)
+{
+	return (size + 7) & ~7;
+}
+
+//! store points and symmetric inverses as structure of arrays
+//! @param[in] &points		reference to the expected points (3xsize)
+//! @param[in] &invVariance	reference to the inverse covariance matrices
+//! @param[out] *d			pointer to the arrays (NB_ARRAYS x stride elements)
+//! @param[in] stride		distance between two arrays of the structure
+template <typename T>
+static void packArrays(const mat &points, const cube &invVariance, T* d, int stride)
+{
+	for (unsigned int j = 0; j < points.n_cols; j++)
+	{
+		d[MX*stride + j] = points(0, j);
+		d[MY*stride + j] = points(1, j);
+		d[MZ*stride + j] = points(2, j);
+
+		// the quadratic form only depends on the symmetric part of the inverse
+		SymMat3<double> S = SymMat3<double>::fromFull(invVariance.slice_memptr(j));
+		d[S00*stride + j] = S.a00;
+		d[S11*stride + j] = S.a11;
+		d[S22*stride + j] = S.a22;
+		d[S01*stride + j] = S.a01;
+		d[S02*stride + j] = S.a02;
+		d[S12*stride + j] = S.a12;
+	}
+}
+
+//! copy constructor (owned arrays are copied, external arrays are shared)
+//! @param[in] &other	reference to the kernel to be copied
+MahalanobisKernel::MahalanobisKernel(const MahalanobisKernel &other)
+{
+	*this = other;
+}
+
+//! assignment operator (owned arrays are copied, external arrays are shared)
+//! @param[in] &other	reference to the kernel to be copied
+//! @return				reference to this kernel
+MahalanobisKernel& MahalanobisKernel::operator=(const MahalanobisKernel &other)
+{
+	size = other.size;
+	stride = other.stride;
+	data = other.data;
+	base = data.empty() ? other.base : &data[0];
+
+	return *this;
+}
+
+//! store the model points and inverse covariance matrices
+//! @param[in] &points		reference to the expected points (3xsize)
+//! @param[in] &invVariance	reference to the inverse covariance matrices
+void MahalanobisKernel::build(const mat &points, const cube &invVariance)
+{
+	size = points.n_cols;
+	stride = strideOf(size);
+	data.assign(NB_ARRAYS * stride, 0);
+	packArrays(points, invVariance, &data[0], stride);
+	base = &data[0];
+}
+
+//! use arrays stored elsewhere (e.g. in a mapped model file)
+//! (double precision pipeline: the arrays are used in place, without copy;
+//! single precision pipeline: the arrays are converted once)
+//! @param[in] *arrays	pointer to the arrays (arraysOf(n) elements, see pack)
+//! @param[in] n		number of model points
+void MahalanobisKernel::attach(const double* arrays, int n)
+{
+	size = n;
+	stride = strideOf(n);
+#ifdef HMP_FLOAT32
+	data.assign(arrays, arrays + NB_ARRAYS * stride);
+	base = &data[0];
+#else
+	data.clear();
+	base = arrays;
+#endif
+}
+
+//! store points and inverses in the layout of the kernel (double precision)
+//! @param[in] &points		reference to the expected points (3xsize)
+//! @param[in] &invVariance	reference to the inverse covariance matrices
+//! @param[out] *arrays		pointer to the arrays (arraysOf(size) elements)
+void MahalanobisKernel::pack(const mat &points, const cube &invVariance, double* arrays)
+{
+	packArrays(points, invVariance, arrays, strideOf(points.n_cols));
+}
+
+//! number of elements of the arrays of a kernel
+//! @param[in] size		number of model points
+//! @return				number of elements (all the arrays of the structure)
+int MahalanobisKernel::arraysOf(int size)
+{
+	return NB_ARRAYS * strideOf(size);
+}
+
+//! sum the distances of trial points [first;last) from the model points
+//! (trial point j is compared with model point j)
+//! @param[in] *trial	pointer to the trial points (3xN, one point per column)
+//! @param[in] first	index of the first point to be compared
+//! @param[in] last		index after the last point to be compared (last <= size)
+//! @return				sum of the Mahalanobis distances
+double MahalanobisKernel::sum(const real_t* trial, int first, int last) const
+{
+	const real_t* d = base;
+	double total = 0;
+	int j = first;
+
+#ifdef HMP_X86_SIMD
+	switch (simdLevel())
+	{
+		case AVX2:
+			total = sumAVX2(d, stride, trial, last, j);
+			break;
+		case SSE2:
+			total = sumSSE2(d, stride, trial, last, j);
+			break;
+	}
+#endif
+	for (; j < last; j++)
+		total += distScalar(d, stride, j, trial + 3 * j);
+
+	return total;
+}
+
+//! compute the distances of one trial point from all the model points
+//! @param[in] *point	pointer to the trial point (x,y,z)
+//! @param[out] *out	pointer to the distances (size elements)
+void MahalanobisKernel::distances(const real_t* point, real_t* out) const
+{
+	const real_t* d = base;
+	int j = 0;
+
+#ifdef HMP_X86_SIMD
+	switch (simdLevel())
+	{
+		case AVX2:
+			distancesAVX2(d, stride, size, point, out, j);
+			break;
+		case SSE2:
+			distancesSSE2(d, stride, size, point, out, j);
+			break;
+	}
+#endif
+	for (; j < size; j++)
+		out[j] = distScalar(d, stride, j, point);
+}
+
+//! get the name of the instruction set used by the kernel
+//! @return		name of the instruction set
+const char* MahalanobisKernel::instructionSet()
+{
+	switch (simdLevel())
+	{
+		case AVX2:
+			return "AVX2";
+		case SSE2:
+			return "SSE2";
+	}
+	return "scalar";
+}
@@ -0,0 +1,83 @@
+//===============================================================================//
+// Name			: mahalanobis.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Batched 3-dimensional Mahalanobis distance kernel (SIMD)
+//===============================================================================//
+
+#include <vector>
+
+#include "utils.hpp"
+
+using namespace arma;
+using namespace std;
+
+#ifndef MAHALANOBIS_HPP_
+#define MAHALANOBIS_HPP_
+
+//! class "MahalanobisKernel" for the distances from the points of one feature
+//! (expected points and inverse covariance matrices of the model are stored
+//! as structure of arrays: 3 coordinates and the 6 unique entries of each
+//! symmetric inverse, so that many model points are scored per instruction)
+class MahalanobisKernel
+{
+	private:
+		int size;				//!< number of model points
+		int stride;				//!< distance between two arrays of the structure
+		vector<real_t> data;	//!< arrays mx, my, mz, s00, s01, s02, s11, s12, s22
+		const real_t* base;		//!< arrays in use (data, or external memory)
+
+		//! distance between two arrays of the structure
+		static int strideOf(int size);
+
+	public:
+		//! constructor
+		MahalanobisKernel()
+		{
+			size = 0;
+			stride = 0;
+			base = NULL;
+		}
+
+		//! copy constructor
+		MahalanobisKernel(const MahalanobisKernel &other);
+
+		//! assignment operator
+		MahalanobisKernel& operator=(const MahalanobisKernel &other);
+
+		//! store the model points and inverse covariance matrices
+		void build(const mat &points, const cube &invVariance);
+
+		//! use arrays stored elsewhere (e.g. in a mapped model file)
+		void attach(const double* arrays, int n);
+
+		//! store points and inverses in the layout of the kernel (double precision)
+		static void pack(const mat &points, const cube &invVariance, double* arrays);
+
+		//! number of elements of the arrays of a kernel
+		static int arraysOf(int size);
+
+		//! sum the distances of the first n trial points from the model points
+		double sum(const real_t* trial, int n) const
+		{
+			return sum(trial, 0, n);
+		}
+
+		//! sum the distances of trial points [first;last) from the model points
+		double sum(const real_t* trial, int first, int last) const;
+
+		//! compute the distances of one trial point from all the model points
+		void distances(const real_t* point, real_t* out) const;
+
+		//! get the name of the instruction set used by the kernel
+		static const char* instructionSet();
+
+		//! destructor
+		~MahalanobisKernel()
+		{
+			//DEBUG:cout<<endl <<"Destroying MahalanobisKernel object" <<endl;
+		}
+};
+
+#endif
@@ -0,0 +1,605 @@
+//===============================================================================//
+// Name			: modelfile.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Model files of an HMP (text parsing, binary memory-mapped format)
+//===============================================================================//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "modelfile.hpp"
+
+//! compute the FNV-1a checksum of a block of memory
+//! @param[in] *data	pointer to the block
+//! @param[in] n		size of the block (bytes)
+//! @return				64-bit checksum
+static uint64_t checksum(const void* data, size_t n)
+{
+	const unsigned char* p = (const unsigned char*) data;
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < n; i++)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+//! map a whole file in memory (read-only)
+//! @param[in] fileName		name of the file
+//! @param[in] minLength	minimum length of the file (bytes)
+//! @param[out] &length		reference to the length of the mapping
+//! @param[out] &info		reference to the status of the file
+//! @return					pointer to the mapping (NULL: file missing or invalid)
+static void* mapFile(string fileName, size_t minLength, size_t &length,
+					 struct stat &info)
+{
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) minLength)
+	{
+		::close(fd);
+		cerr<<"Invalid file (too short): " <<fileName <<endl;
+		return NULL;
+	}
+	length = info.st_size;
+	void* map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+	{
+		cerr<<"Cannot map file: " <<fileName <<endl;
+		return NULL;
+	}
+
+	return map;
+}
+
+//! write a file atomically (temporary file renamed over the old one, so that
+//! the readers map either the old or the new file, never a partial one)
+//! @param[in] fileName	name of the file
+//! @param[in] *header	pointer to the header
+//! @param[in] nHeader	size of the header (bytes)
+//! @param[in] *payload	pointer to the payload
+//! @param[in] nPayload	size of the payload (bytes)
+static void writeFile(string fileName, const void* header, size_t nHeader,
+					  const void* payload, size_t nPayload)
+{
+	string tmpName = fileName + ".tmp";
+	ofstream file(tmpName.c_str(), ios::binary);
+	file.write((const char*) header, nHeader);
+	file.write((const char*) payload, nPayload);
+	file.close();
+	if (!file || rename(tmpName.c_str(), fileName.c_str()) != 0)
+	{
+		remove(tmpName.c_str());
+		throw runtime_error("cannot write file: " + fileName);
+	}
+}
+
+//! compute the position of the blocks of a model
+//! (every block is padded to a multiple of 8 doubles, i.e. 64 bytes)
+//! @param[in] size		number of model points
+//! @param[out] *offset	offset of each block from the first one (doubles)
+//! @param[out] *count	number of meaningful elements of each block
+//! @return				size of all the blocks (doubles)
+size_t ModelFile::layout(int size, size_t* offset, size_t* count)
+{
+	size_t total = 0;
+	for (int b = 0; b < NB_MODEL_BLOCKS; b++)
+	{
+		switch (b % 4)
+		{
+			case 0:
+				count[b] = 3 * size;
+				break;
+			case 1:
+			case 2:
+				count[b] = 9 * size;
+				break;
+			default:
+				count[b] = MahalanobisKernel::arraysOf(size);
+		}
+		offset[b] = total;
+		total += (count[b] + 7) & ~((size_t) 7);
+	}
+
+	return total;
+}
+
+//! map and validate a binary model file
+//! (checks magic, version, dimensions, length and checksum)
+//! @param[in] fileName	name of the binary model file
+//! @return				true if the file is mapped and valid
+bool ModelFile::open(string fileName)
+{
+	close();
+
+	struct stat info;
+	map = mapFile(fileName, sizeof(ModelFileHeader), length, info);
+	if (map == NULL)
+		return false;
+
+	// validate the header and the blocks
+	const ModelFileHeader* header = (const ModelFileHeader*) map;
+	size_t offset[NB_MODEL_BLOCKS];
+	size_t count[NB_MODEL_BLOCKS];
+	string error;
+	if (memcmp(header->magic, "HMPMODEL", 8) != 0)
+		error = "not a model file";
+	else if (header->version != VERSION)
+		error = "unsupported version";
+	else if (header->headerSize != sizeof(ModelFileHeader)
+			 || header->nbBlocks != NB_MODEL_BLOCKS || header->size == 0)
+		error = "invalid header";
+	else if (header->payloadSize != layout(header->size, offset, count) * sizeof(double)
+			 || length != header->headerSize + header->payloadSize)
+		error = "invalid length";
+	else if (header->checksum != checksum((const char*) map + header->headerSize,
+										  header->payloadSize))
+		error = "checksum mismatch";
+	if (!error.empty())
+	{
+		cerr<<"Invalid model file (" <<error <<"): " <<fileName <<endl;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//! get the number of model points
+//! @return		number of model points
+int ModelFile::size() const
+{
+	return ((const ModelFileHeader*) map)->size;
+}
+
+//! get the pointer to one block of the model
+//! @param[in] b	block of the model
+//! @return			pointer to the first element of the block (64-byte aligned)
+const double* ModelFile::block(ModelBlock b) const
+{
+	size_t offset[NB_MODEL_BLOCKS];
+	size_t count[NB_MODEL_BLOCKS];
+	layout(size(), offset, count);
+	const double* first = (const double*) ((const char*) map + sizeof(ModelFileHeader));
+
+	return first + offset[b];
+}
+
+//! release the mapping
+void ModelFile::close()
+{
+	if (map != NULL)
+		munmap(map, length);
+	map = NULL;
+	length = 0;
+}
+
+//! fill the blocks of a model (appended to the given blocks)
+//! (all the arrays must describe the same number of points)
+//! @param[in] &gP			reference to the gravity expected points (3xsize)
+//! @param[in] &gS			reference to the gravity covariance matrices
+//! @param[in] &gSi			reference to the gravity inverse covariance matrices
+//! @param[in] &bP			reference to the body acc. expected points (3xsize)
+//! @param[in] &bS			reference to the body acc. covariance matrices
+//! @param[in] &bSi			reference to the body acc. inverse covariance matrices
+//! @param[in,out] &blocks	reference to the blocks (doubles)
+void ModelFile::serialize(const mat &gP, const cube &gS, const cube &gSi,
+						  const mat &bP, const cube &bS, const cube &bSi,
+						  vector<double> &blocks)
+{
+	int size = gP.n_cols;
+	if (gS.n_slices != gP.n_cols || gSi.n_slices != gP.n_cols
+		|| bP.n_cols != gP.n_cols || bS.n_slices != gP.n_cols
+		|| bSi.n_slices != gP.n_cols)
+		throw runtime_error("malformed model files: inconsistent sizes");
+	size_t offset[NB_MODEL_BLOCKS];
+	size_t count[NB_MODEL_BLOCKS];
+	size_t first = blocks.size();
+	blocks.resize(first + layout(size, offset, count), 0);
+	double* p = &blocks[first];
+
+	memcpy(p + offset[GRAVITY_MU], gP.memptr(), count[GRAVITY_MU] * sizeof(double));
+	memcpy(p + offset[GRAVITY_SIGMA], gS.memptr(), count[GRAVITY_SIGMA] * sizeof(double));
+	memcpy(p + offset[GRAVITY_INVERSE], gSi.memptr(), count[GRAVITY_INVERSE] * sizeof(double));
+	MahalanobisKernel::pack(gP, gSi, p + offset[GRAVITY_KERNEL]);
+	memcpy(p + offset[BODY_MU], bP.memptr(), count[BODY_MU] * sizeof(double));
+	memcpy(p + offset[BODY_SIGMA], bS.memptr(), count[BODY_SIGMA] * sizeof(double));
+	memcpy(p + offset[BODY_INVERSE], bSi.memptr(), count[BODY_INVERSE] * sizeof(double));
+	MahalanobisKernel::pack(bP, bSi, p + offset[BODY_KERNEL]);
+}
+
+//! write a binary model file
+//! @param[in] fileName	name of the binary model file
+//! @param[in] &gP		reference to the gravity expected points (3xsize)
+//! @param[in] &gS		reference to the gravity covariance matrices
+//! @param[in] &gSi		reference to the gravity inverse covariance matrices
+//! @param[in] &bP		reference to the body acc. expected points (3xsize)
+//! @param[in] &bS		reference to the body acc. covariance matrices
+//! @param[in] &bSi		reference to the body acc. inverse covariance matrices
+void ModelFile::write(string fileName, const mat &gP, const cube &gS,
+					  const cube &gSi, const mat &bP, const cube &bS,
+					  const cube &bSi)
+{
+	vector<double> payload;
+	serialize(gP, gS, gSi, bP, bS, bSi, payload);
+	const double* p = &payload[0];
+
+	ModelFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "HMPMODEL", 8);
+	header.version = VERSION;
+	header.size = gP.n_cols;
+	header.headerSize = sizeof(ModelFileHeader);
+	header.nbBlocks = NB_MODEL_BLOCKS;
+	header.payloadSize = payload.size() * sizeof(double);
+	header.checksum = checksum(p, header.payloadSize);
+
+	writeFile(fileName, &header, sizeof(header), p, header.payloadSize);
+}
+
+//! map and validate a dataset pack
+//! (checks magic, version, table of contents, length and checksum)
+//! @param[in] fileName	name of the dataset pack
+//! @return				true if the file is mapped and valid
+bool DatasetPack::open(string fileName)
+{
+	close();
+
+	struct stat info;
+	map = mapFile(fileName, sizeof(DatasetPackHeader), length, info);
+	if (map == NULL)
+		return false;
+	identity[0] = info.st_dev;
+	identity[1] = info.st_ino;
+	identity[2] = info.st_mtime;
+
+	// validate the header
+	const DatasetPackHeader* header = (const DatasetPackHeader*) map;
+	string error;
+	if (memcmp(header->magic, "HMPDSPAK", 8) != 0)
+		error = "not a dataset pack";
+	else if (header->version != VERSION)
+		error = "unsupported version";
+	else if (header->headerSize != sizeof(DatasetPackHeader)
+			 || header->entrySize != sizeof(DatasetPackEntry)
+			 || header->nbModels == 0)
+		error = "invalid header";
+	else if (length != header->headerSize + header->payloadSize
+			 || header->payloadSize < header->nbModels * sizeof(DatasetPackEntry))
+		error = "invalid length";
+	else if (header->checksum != checksum((const char*) map + header->headerSize,
+										  header->payloadSize))
+		error = "checksum mismatch";
+
+	// validate the table of contents (every model within the file)
+	size_t nBlocks = (header->payloadSize
+					  - header->nbModels * sizeof(DatasetPackEntry)) / sizeof(double);
+	size_t offset[NB_MODEL_BLOCKS];
+	size_t count[NB_MODEL_BLOCKS];
+	for (int i = 0; error.empty() && i < nbModels(); i++)
+	{
+		const DatasetPackEntry &e = entry(i);
+		if (memchr(e.name, '\0', sizeof(e.name)) == NULL || e.size == 0
+			|| e.offset % 8 != 0
+			|| e.offset + ModelFile::layout(e.size, offset, count) > nBlocks)
+			error = "invalid table of contents";
+	}
+	if (!error.empty())
+	{
+		cerr<<"Invalid dataset pack (" <<error <<"): " <<fileName <<endl;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//! get the (shared) mapping of a dataset pack
+//! (every user of the same file gets the same mapping, until the file is replaced)
+//! @param[in] fileName	name of the dataset pack
+//! @return				mapped dataset pack (empty: missing or invalid file)
+boost::shared_ptr<const DatasetPack> DatasetPack::load(string fileName)
+{
+	static boost::mutex lock;
+	static std::map<string, boost::weak_ptr<const DatasetPack> > mapped;
+
+	boost::mutex::scoped_lock guard(lock);
+	boost::shared_ptr<const DatasetPack> pack = mapped[fileName].lock();
+	struct stat info;
+	if (stat(fileName.c_str(), &info) != 0)
+		return boost::shared_ptr<const DatasetPack>();
+	if (pack && pack->identity[0] == (uint64_t) info.st_dev
+		&& pack->identity[1] == (uint64_t) info.st_ino
+		&& pack->identity[2] == (uint64_t) info.st_mtime)
+		return pack;
+
+	boost::shared_ptr<DatasetPack> opened(new DatasetPack());
+	if (!opened->open(fileName))
+		return boost::shared_ptr<const DatasetPack>();
+	mapped[fileName] = opened;
+
+	return opened;
+}
+
+//! get the number of models
+//! @return		number of models
+int DatasetPack::nbModels() const
+{
+	return ((const DatasetPackHeader*) map)->nbModels;
+}
+
+//! get the entry of one model in the table of contents
+//! @param[in] i	index of the model
+//! @return			entry of the model
+const DatasetPackEntry& DatasetPack::entry(int i) const
+{
+	const DatasetPackEntry* toc = (const DatasetPackEntry*)
+		((const char*) map + sizeof(DatasetPackHeader));
+
+	return toc[i];
+}
+
+//! get the classification parameters of all the models
+//! @param[out] &models	reference to the parameters of the models
+void DatasetPack::config(vector<ModelConfig> &models) const
+{
+	models.resize(nbModels());
+	for (int i = 0; i < nbModels(); i++)
+	{
+		const DatasetPackEntry &e = entry(i);
+		models[i].name = e.name;
+		models[i].gravityWeight = e.gravityWeight;
+		models[i].bodyWeight = e.bodyWeight;
+		models[i].threshold = e.threshold;
+	}
+}
+
+//! get the first block of the first model (after the table of contents)
+//! @return		pointer to the first block (64-byte aligned)
+const double* DatasetPack::blocks() const
+{
+	return (const double*) ((const char*) map + sizeof(DatasetPackHeader)
+							+ nbModels() * sizeof(DatasetPackEntry));
+}
+
+//! get the pointer to one block of one model
+//! @param[in] i	index of the model
+//! @param[in] b	block of the model
+//! @return			pointer to the first element of the block (64-byte aligned)
+const double* DatasetPack::block(int i, ModelBlock b) const
+{
+	size_t offset[NB_MODEL_BLOCKS];
+	size_t count[NB_MODEL_BLOCKS];
+	ModelFile::layout(entry(i).size, offset, count);
+
+	return blocks() + entry(i).offset + offset[b];
+}
+
+//! release the mapping
+void DatasetPack::close()
+{
+	if (map != NULL)
+		munmap(map, length);
+	map = NULL;
+	length = 0;
+}
+
+//! write a dataset pack
+//! @param[in] fileName	name of the dataset pack
+//! @param[in] &toc		reference to the table of contents
+//! @param[in] &blocks	reference to the blocks of all the models (doubles)
+void DatasetPack::write(string fileName, const vector<DatasetPackEntry> &toc,
+						const vector<double> &blocks)
+{
+	size_t nToc = toc.size() * sizeof(DatasetPackEntry);
+	vector<char> payload(nToc + blocks.size() * sizeof(double));
+	memcpy(&payload[0], &toc[0], nToc);
+	memcpy(&payload[nToc], &blocks[0], blocks.size() * sizeof(double));
+
+	DatasetPackHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "HMPDSPAK", 8);
+	header.version = VERSION;
+	header.nbModels = toc.size();
+	header.headerSize = sizeof(DatasetPackHeader);
+	header.entrySize = sizeof(DatasetPackEntry);
+	header.payloadSize = payload.size();
+	header.checksum = checksum(&payload[0], payload.size());
+
+	writeFile(fileName, &header, sizeof(header), &payload[0], payload.size());
+}
+
+//! get the modification time of a file
+//! @param[in] fileName	name of the file
+//! @return				ns since the epoch (0: missing file)
+uint64_t fileTime(string fileName)
+{
+	struct stat info;
+	if (stat(fileName.c_str(), &info) != 0)
+		return 0;
+
+	return (uint64_t) info.st_mtim.tv_sec * 1000000000ULL + info.st_mtim.tv_nsec;
+}
+
+//! get the modification time of the newest text file of a model
+//! (Mu and Sigma of both features, as written by Creator)
+//! @param[in] HMPname	name of the model (folder of the dataset included)
+//! @return				ns since the epoch (0: no text file)
+uint64_t modelTextTime(string HMPname)
+{
+	const char* files[4] = {"MuGravity.txt", "MuBody.txt",
+							"SigmaGravity.txt", "SigmaBody.txt"};
+	uint64_t newest = 0;
+	for (int i = 0; i < 4; i++)
+		newest = max(newest, fileTime(HMPname + files[i]));
+
+	return newest;
+}
+
+//! check that a dataset pack is newer than the files it was built from
+//! (Classifierconfig.txt and the text and binary files of its models)
+//! @param[in] &pack		reference to the dataset pack
+//! @param[in] fileName		name of the dataset pack
+//! @param[in] folder		folder of the dataset
+//! @return					true if no covered file changed after the pack
+static bool isCurrent(const DatasetPack &pack, string fileName, string folder)
+{
+	uint64_t built = fileTime(fileName);
+	if (fileTime(folder + "Classifierconfig.txt") > built)
+		return false;
+	for (int i = 0; i < pack.nbModels(); i++)
+	{
+		const DatasetPackEntry &e = pack.entry(i);
+		string HMPname = folder + string(e.name, strnlen(e.name, sizeof(e.name)));
+		if (modelTextTime(HMPname) > built
+			|| fileTime(HMPname + MODEL_FILE_EXTENSION) > built)
+			return false;
+	}
+
+	return true;
+}
+
+//! read the classification parameters of the models from Classifierconfig.txt
+//! (number of models, then name, gravity weight, body weight, threshold)
+//! @param[in] fileName	name of the configuration file
+//! @param[out] &models	reference to the parameters of the models
+void readClassifierConfig(string fileName, vector<ModelConfig> &models)
+{
+	ifstream configFile(fileName.c_str());
+	int nbM = 0;
+	configFile >>nbM;
+	if (!configFile || nbM <= 0)
+		throw runtime_error("malformed config file: " + fileName);
+	models.resize(nbM);
+	for (int i = 0; i < nbM; i++)
+	{
+		configFile >>models[i].name >>models[i].gravityWeight
+				   >>models[i].bodyWeight >>models[i].threshold;
+		if (!configFile)
+			throw runtime_error("malformed config file: " + fileName);
+	}
+	configFile.close();
+}
+
+//! read the list of the models of a dataset
+//! (from its pack if available and not older than the files it covers, from
+//! Classifierconfig.txt otherwise: retrained models are never shadowed)
+//! @param[in] dF		name of the dataset
+//! @param[out] &models	reference to the parameters of the models
+//! @return				mapped dataset pack (empty: loose model files)
+boost::shared_ptr<const DatasetPack> readDataset(string dF,
+												 vector<ModelConfig> &models)
+{
+	string fileName = "./Models/" + dF + DATASET_PACK_EXTENSION;
+	boost::shared_ptr<const DatasetPack> pack = DatasetPack::load(fileName);
+	if (pack && !isCurrent(*pack, fileName, "./Models/" + dF + "/"))
+	{
+		cerr<<"Dataset pack older than the model files, ignored "
+			<<"(run -x to rebuild it): " <<fileName <<endl;
+		pack.reset();
+	}
+	if (pack)
+		pack->config(models);
+	else
+		readClassifierConfig("./Models/" + dF + "/Classifierconfig.txt", models);
+
+	return pack;
+}
+
+//! read all the numbers of a text model file (separated by spaces or commas)
+//! (single precision, as written by the GMM+GMR library)
+//! @param[in] fileName	name of the text file
+//! @param[out] &values	reference to the numbers of the file
+static void readNumbers(string fileName, vector<float> &values)
+{
+	ifstream file(fileName.c_str(), ios::binary);
+	if (!file)
+		throw runtime_error("cannot open model file: " + fileName);
+	string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	file.close();
+
+	const char* p = text.c_str();
+	while (true)
+	{
+		while (*p == ' ' || *p == ',' || *p == '\t' || *p == '\n' || *p == '\r')
+			p++;
+		if (*p == '\0')
+			break;
+		char* end;
+		float value = strtof(p, &end);
+		if (end == p)
+			throw runtime_error("malformed model file: " + fileName);
+		values.push_back(value);
+		p = end;
+	}
+}
+
+//! load the expected points (Mu) of one feature from a text file
+//! (the "time" column is discarded: one expected point per column)
+//! @param[in] fileName	name of the text file
+//! @return				matrix of the expected points of the feature (3xsize)
+mat readMuText(string fileName)
+{
+	vector<float> values;
+	readNumbers(fileName, values);
+	if (values.size() < 2)
+		throw runtime_error("malformed model file: " + fileName);
+	int col = (int) values[0];
+	int row = (int) values[1];
+	if (col != 4 || row <= 0 || values.size() != (size_t) (2 + row * col))
+		throw runtime_error("malformed model file: " + fileName);
+
+	mat mod = zeros<mat>(col - 1, row);
+	for (int r = 0; r < row; r++)
+		for (int c = 1; c < col; c++)
+			mod(c - 1, r) = values[2 + r * col + c];
+
+	return mod;
+}
+
+//! load the expected variances (Sigma) of one feature from a text file
+//! @param[in] fileName	name of the text file
+//! @return				set of the covariance matrices of the feature
+cube readSigmaText(string fileName)
+{
+	vector<float> values;
+	readNumbers(fileName, values);
+	if (values.size() < 3)
+		throw runtime_error("malformed model file: " + fileName);
+	int row = (int) values[0];
+	int col = (int) values[1];
+	int slice = (int) values[2];
+	if (row != 3 || col != 3 || slice <= 0
+		|| values.size() != (size_t) (3 + row * col * slice))
+		throw runtime_error("malformed model file: " + fileName);
+
+	cube mod = zeros<cube>(row, col, slice);
+	const float* v = &values[3];
+	for (int s = 0; s < slice; s++)
+		for (int r = 0; r < row; r++)
+			for (int c = 0; c < col; c++)
+				mod(r, c, s) = *v++;
+
+	return mod;
+}
@@ -0,0 +1,231 @@
+//===============================================================================//
+// Name			: modelfile.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Model files of an HMP (text parsing, binary memory-mapped format)
+//===============================================================================//
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include "mahalanobis.hpp"
+#include "utils.hpp"
+
+using namespace arma;
+using namespace std;
+
+#ifndef MODELFILE_HPP_
+#define MODELFILE_HPP_
+
+//! extension of the binary model files (appended to the name of the HMP)
+static const char* const MODEL_FILE_EXTENSION = ".hmpm";
+
+//! extension of the dataset packs (appended to the folder of the dataset)
+static const char* const DATASET_PACK_EXTENSION = ".hmpd";
+
+//! blocks of a binary model file (in order)
+enum ModelBlock
+{
+	GRAVITY_MU,				//!< gravity expected points (3xsize)
+	GRAVITY_SIGMA,			//!< gravity covariance matrices (3x3xsize)
+	GRAVITY_INVERSE,		//!< gravity inverse covariance matrices (3x3xsize)
+	GRAVITY_KERNEL,			//!< gravity distance kernel arrays
+	BODY_MU,				//!< body acc. expected points (3xsize)
+	BODY_SIGMA,				//!< body acc. covariance matrices (3x3xsize)
+	BODY_INVERSE,			//!< body acc. inverse covariance matrices (3x3xsize)
+	BODY_KERNEL,			//!< body acc. distance kernel arrays
+	NB_MODEL_BLOCKS
+};
+
+//! header of a binary model file
+//! (64 bytes; the blocks follow, each one 64-byte aligned, stored as doubles)
+struct ModelFileHeader
+{
+	char magic[8];			//!< "HMPMODEL"
+	uint32_t version;		//!< version of the format
+	uint32_t size;			//!< number of model points
+	uint32_t headerSize;	//!< size of the header (offset of the first block)
+	uint32_t nbBlocks;		//!< number of blocks
+	uint64_t payloadSize;	//!< size of all the blocks (bytes)
+	uint64_t checksum;		//!< FNV-1a checksum of the blocks
+	char reserved[24];		//!< reserved (zero)
+};
+
+//! class "ModelFile", binary model file of an HMP mapped in memory
+//! (the arrays are used in place: nothing is parsed or copied when loading)
+class ModelFile
+{
+	private:
+		void* map;				//!< mapped file (NULL: not mapped)
+		size_t length;			//!< length of the mapping
+
+		//! copy constructor (not allowed: the mapping is owned by the object)
+		ModelFile(const ModelFile &other);
+
+		//! assignment operator (not allowed: the mapping is owned by the object)
+		ModelFile& operator=(const ModelFile &other);
+
+		//! release the mapping
+		void close();
+
+	public:
+		static const uint32_t VERSION = 1;		//!< current version of the format
+
+		//! constructor
+		ModelFile()
+		{
+			map = NULL;
+			length = 0;
+		}
+
+		//! map and validate a binary model file
+		bool open(string fileName);
+
+		//! get the number of model points
+		int size() const;
+
+		//! get the pointer to one block of the model
+		const double* block(ModelBlock b) const;
+
+		//! compute the position of the blocks of a model
+		static size_t layout(int size, size_t* offset, size_t* count);
+
+		//! fill the blocks of a model (as stored in model files and dataset packs)
+		static void serialize(const mat &gP, const cube &gS, const cube &gSi,
+							  const mat &bP, const cube &bS, const cube &bSi,
+							  vector<double> &blocks);
+
+		//! write a binary model file
+		static void write(string fileName, const mat &gP, const cube &gS,
+						  const cube &gSi, const mat &bP, const cube &bS,
+						  const cube &bSi);
+
+		//! destructor (releases the mapping)
+		~ModelFile()
+		{
+			close();
+			//DEBUG:cout<<endl <<"Destroying ModelFile object" <<endl;
+		}
+};
+
+//! classification parameters of one HMP (one line of Classifierconfig.txt)
+struct ModelConfig
+{
+	string name;			//!< name of the HMP within the dataset
+	float gravityWeight;	//!< weight of gravity feature for classification
+	float bodyWeight;		//!< weight of body acc. feature for classification
+	float threshold;		//!< max distance for possible motion occurrence
+};
+
+//! entry of the table of contents of a dataset pack (64 bytes)
+struct DatasetPackEntry
+{
+	char name[40];			//!< name of the HMP within the dataset (NUL-terminated)
+	float gravityWeight;	//!< weight of gravity feature for classification
+	float bodyWeight;		//!< weight of body acc. feature for classification
+	float threshold;		//!< max distance for possible motion occurrence
+	uint32_t size;			//!< number of model points
+	uint64_t offset;		//!< offset of the blocks of the model (doubles)
+};
+
+//! header of a dataset pack
+//! (64 bytes; the table of contents follows, then the blocks of each model
+//! with the layout of a model file, stored as doubles and 64-byte aligned)
+struct DatasetPackHeader
+{
+	char magic[8];			//!< "HMPDSPAK"
+	uint32_t version;		//!< version of the format
+	uint32_t nbModels;		//!< number of models (entries of the table)
+	uint32_t headerSize;	//!< size of the header (offset of the table)
+	uint32_t entrySize;		//!< size of one entry of the table
+	uint64_t payloadSize;	//!< size of the table and of all the blocks (bytes)
+	uint64_t checksum;		//!< FNV-1a checksum of the table and of the blocks
+	char reserved[24];		//!< reserved (zero)
+};
+
+//! class "DatasetPack", all the models of a dataset in one file mapped in memory
+//! (configuration and models: one mapping per file, shared by all its users)
+class DatasetPack
+{
+	private:
+		void* map;				//!< mapped file (NULL: not mapped)
+		size_t length;			//!< length of the mapping
+		uint64_t identity[3];	//!< device, inode and modification time of the file
+
+		//! copy constructor (not allowed: the mapping is owned by the object)
+		DatasetPack(const DatasetPack &other);
+
+		//! assignment operator (not allowed: the mapping is owned by the object)
+		DatasetPack& operator=(const DatasetPack &other);
+
+		//! map and validate a dataset pack
+		bool open(string fileName);
+
+		//! get the first block of the first model
+		const double* blocks() const;
+
+		//! release the mapping
+		void close();
+
+	public:
+		static const uint32_t VERSION = 1;		//!< current version of the format
+
+		//! constructor
+		DatasetPack()
+		{
+			map = NULL;
+			length = 0;
+		}
+
+		//! get the (shared) mapping of a dataset pack
+		static boost::shared_ptr<const DatasetPack> load(string fileName);
+
+		//! get the number of models
+		int nbModels() const;
+
+		//! get the entry of one model in the table of contents
+		const DatasetPackEntry& entry(int i) const;
+
+		//! get the classification parameters of all the models
+		void config(vector<ModelConfig> &models) const;
+
+		//! get the pointer to one block of one model
+		const double* block(int i, ModelBlock b) const;
+
+		//! write a dataset pack
+		static void write(string fileName, const vector<DatasetPackEntry> &toc,
+						  const vector<double> &blocks);
+
+		//! destructor (releases the mapping)
+		~DatasetPack()
+		{
+			close();
+			//DEBUG:cout<<endl <<"Destroying DatasetPack object" <<endl;
+		}
+};
+
+//! get the modification time of a file (ns since the epoch, 0: missing)
+uint64_t fileTime(string fileName);
+
+//! get the modification time of the newest text file of a model (0: missing)
+uint64_t modelTextTime(string HMPname);
+
+//! read the classification parameters of the models from Classifierconfig.txt
+void readClassifierConfig(string fileName, vector<ModelConfig> &models);
+
+//! read the list of the models of a dataset (pack if available, text otherwise)
+boost::shared_ptr<const DatasetPack> readDataset(string dF,
+												 vector<ModelConfig> &models);
+
+//! load the expected points (Mu) of one feature from a text file
+mat readMuText(string fileName);
+
+//! load the expected variances (Sigma) of one feature from a text file
+cube readSigmaText(string fileName);
+
+#endif
@@ -0,0 +1,99 @@
+//===============================================================================//
+// Name			: preprocessor.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Streaming (causal) extraction of gravity and body acc. features
+//===============================================================================//
+
+#include <algorithm>
+
+#include "preprocessor.hpp"
+#include "triaxial.hpp"
+
+//! constructor
+//! @param[in] windowSize	size of the feature buffers
+//! @param[in] &f			reference to the configuration of the low-pass filter
+//! @param[in] mS			size of the median filter (odd)
+Preprocessor::Preprocessor(int windowSize, const FilterConfig &f, int mS)
+	: filter(f)
+{
+	medianSize = mS;
+	reset(windowSize);
+}
+
+//! reset the filters state and empty the feature buffers
+//! @param[in] windowSize	size of the feature buffers
+void Preprocessor::reset(int windowSize)
+{
+	// the median window is zero-padded at the beginning (as in medianFilter)
+	history.assign(3 * medianSize, 0);
+	scratch.assign(medianSize, 0);
+	next = 0;
+	numRead = 0;
+
+	filter.reset();
+
+	gravity.resize(windowSize);
+	body.resize(windowSize);
+}
+
+//! design the low-pass filter again (filter state reset)
+//! @param[in] &f	reference to the configuration of the low-pass filter
+void Preprocessor::configure(const FilterConfig &f)
+{
+	filter.configure(f);
+}
+
+//! set the size of the feature buffers, keeping the filters state
+//! (and the most recent features, as many as fit in the new size)
+//! @param[in] windowSize	size of the feature buffers
+void Preprocessor::resizeWindow(int windowSize)
+{
+	gravity.resizeKeep(windowSize);
+	body.resizeKeep(windowSize);
+}
+
+//! compute the median of one axis of the stored raw samples
+//! @param[in] axis		index of the axis (0: x, 1: y, 2: z)
+//! @return				median of the last medianSize samples along the axis
+real_t Preprocessor::medianAxis(int axis)
+{
+	if (medianSize == 3)
+		return median3(history[axis], history[3 + axis], history[6 + axis]);
+	for (int i = 0; i < medianSize; i++)
+		scratch[i] = history[3 * i + axis];
+	nth_element(scratch.begin(), scratch.begin() + medianSize / 2, scratch.end());
+
+	return scratch[medianSize / 2];
+}
+
+//! process one raw sample
+//! (the median filter is centered: the features lag medianSize/2 samples)
+//! @param[in] &one_sample	reference to the raw sample (1x3)
+//! @return					true if a new feature sample has been produced
+bool Preprocessor::push(const mat &one_sample)
+{
+	// store the raw sample
+	for (int axis = 0; axis < 3; axis++)
+		history[3 * next + axis] = one_sample(axis);
+	next = (next + 1 == medianSize) ? 0 : next + 1;
+	numRead = numRead + 1;
+	if (numRead <= medianSize / 2)
+		return false;
+
+	// perform median filtering to reduce the noise
+	Vec3<real_t> clean(medianAxis(0), medianAxis(1), medianAxis(2));
+
+	// discriminate between gravity and body acc. components
+	// (in the precision of the pipeline, as in ChebyshevFilter)
+	real_t low[3] = {clean.x, clean.y, clean.z};
+	filter.processStrided(1, low, 3, 1);
+
+	Vec3<real_t> lowpass(low[0], low[1], low[2]);
+	Vec3<real_t> highpass = clean - lowpass;
+	gravity.push(lowpass.x, lowpass.y, lowpass.z);
+	body.push(highpass.x, highpass.y, highpass.z);
+
+	return true;
+}
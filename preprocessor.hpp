@@ -0,0 +1,70 @@
+//===============================================================================//
+// Name			: preprocessor.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Streaming (causal) extraction of gravity and body acc. features
+//===============================================================================//
+
+#include <vector>
+
+#include "samplebuffer.hpp"
+#include "utils.hpp"
+
+using namespace arma;
+using namespace std;
+
+#ifndef PREPROCESSOR_HPP_
+#define PREPROCESSOR_HPP_
+
+//! class "Preprocessor" for the sample-by-sample extraction of the features
+//! (median and ChebyshevI filters keep their state across samples, so that
+//! each raw sample produces exactly one gravity and one body acc. sample)
+class Preprocessor
+{
+	private:
+		int medianSize;			//!< size of the median filter
+		vector<real_t> history;	//!< last medianSize raw samples (x,y,z each)
+		vector<real_t> scratch;	//!< support vector for the median computation
+		int next;				//!< position of the next raw sample in history
+		int numRead;			//!< number of raw samples received
+		GravityFilter filter;	//!< low-pass filter (state kept across samples)
+
+		//! compute the median of one axis of the stored raw samples
+		real_t medianAxis(int axis);
+
+	public:
+		SampleBuffer gravity;	//!< rolling buffer of the gravity feature
+		SampleBuffer body;		//!< rolling buffer of the body acc. feature
+
+		//! constructor
+		Preprocessor(int windowSize, const FilterConfig &f = FilterConfig(),
+					 int mS = 3);
+
+		//! design the low-pass filter again (filter state reset)
+		void configure(const FilterConfig &f);
+
+		//! reset the filters state and empty the feature buffers
+		void reset(int windowSize);
+
+		//! set the size of the feature buffers, keeping the filters state
+		void resizeWindow(int windowSize);
+
+		//! process one raw sample
+		bool push(const mat &one_sample);
+
+		//! check whether the feature buffers hold a full window
+		//! @return		true if a full window of features is available
+		bool isFull() const
+		{
+			return gravity.isFull();
+		}
+
+		//! destructor
+		~Preprocessor()
+		{
+			//DEBUG:cout<<endl <<"Destroying Preprocessor object" <<endl;
+		}
+};
+
+#endif
@@ -6,6 +6,7 @@
 // Description	: Interface for the publishing middleware (virtual base class)
 //===============================================================================//
 
+#include <cstdio>
 #include <string>
 
 using namespace std;
@@ -13,6 +14,66 @@ using namespace std;
 #ifndef PUBLISHER_HPP_
 #define PUBLISHER_HPP_
 
+//! append a number to a string (as an output stream would write it)
+//! @param[in,out] &out	reference to the string
+//! @param[in] value	number to be appended
+inline void appendNumber(string &out, double value)
+{
+	char buffer[32];
+	int n = snprintf(buffer, sizeof(buffer), "%g", value);
+	out.append(buffer, n);
+}
+
+//! append the possibilities of the models to a string (" p1 p2 ... pN")
+//! @param[in,out] &out			reference to the string
+//! @param[in] *possibilities	pointer to the possibilities
+//! @param[in] n				number of possibilities
+inline void appendPossibilities(string &out, const float* possibilities, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		out.append(" ");
+		appendNumber(out, possibilities[i]);
+	}
+}
+
+//! record "ModelsRecord", static information (loaded HMPs)
+struct ModelsRecord
+{
+	int nbM;					//!< number of models
+	const string* names;		//!< names of the models (nbM values)
+};
+
+//! record "ResultRecord", dynamic information (recognition results of a window)
+//! (numeric: the values are formatted by the publisher, if ever)
+struct ResultRecord
+{
+	int sample;					//!< index of the last sample of the window
+	int nbM;					//!< number of models
+	const float* possibilities;	//!< possibilities of the models (nbM values)
+	const string* names;		//!< names of the models (nbM values)
+	int best;					//!< model with highest possibility (-1: none)
+	int secondBest;				//!< model with second-highest possibility (-1: none)
+
+	//! possibility that none of the models is occurring
+	//! @return		1 - highest possibility
+	float other() const
+	{
+		return (best == -1) ? 1 : 1 - possibilities[best];
+	}
+
+	//! margin of the highest possibility over the second-highest one
+	//! @return		margin (-1: no model is occurring)
+	float entropy() const
+	{
+		if (best == -1)
+			return -1;
+		if (secondBest == -1)
+			return possibilities[best];
+		return possibilities[best] - possibilities[secondBest];
+	}
+};
+
 //! base class "Publisher" for the interface to the information publishing middleware
 class Publisher
 {
@@ -37,6 +98,45 @@ class Publisher
         //! @param[in] key     key of the information to be published
         //! @param[in] value   value of the information to be published
         virtual void publish(const string key, const string value) = 0;
+
+        //! publish the static information (loaded HMPs)
+        //! (default adapter: "numModels" and "nameModels" strings)
+        //! @param[in] &m      reference to the static information
+        virtual void publishModels(const ModelsRecord &m)
+        {
+            string value;
+            appendNumber(value, m.nbM);
+            publish("numModels", value);
+            value.clear();
+            for (int i = 0; i < m.nbM; i++)
+                value.append(m.names[i]).append(" ");
+            publish("nameModels", value);
+        }
+
+        //! publish the dynamic information (recognition results)
+        //! (default adapter: "possibilities", "highest", "other" and
+        //! "entropy" strings)
+        //! @param[in] &r      reference to the recognition results
+        virtual void publishResults(const ResultRecord &r)
+        {
+            string value;
+            value.reserve(12 * r.nbM);
+            appendPossibilities(value, r.possibilities, r.nbM);
+            publish("possibilities", value);
+            publish("highest", (r.best == -1) ? string("NONE") : r.names[r.best]);
+            value.clear();
+            appendNumber(value, r.other());
+            publish("other", value);
+            value.clear();
+            appendNumber(value, r.entropy());
+            publish("entropy", value);
+        }
+
+        //! destructor
+        virtual ~Publisher()
+        {
+            //DEBUG:cout<<endl <<"Destroying Publisher object" <<endl;
+        }
 };
 
 #endif
@@ -0,0 +1,151 @@
+//===============================================================================//
+// Name			: samplebuffer.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Circular buffer of tri-axial samples (window of the classifier)
+//===============================================================================//
+
+#include "utils.hpp"
+
+using namespace arma;
+
+#ifndef SAMPLEBUFFER_HPP_
+#define SAMPLEBUFFER_HPP_
+
+//! class "SampleBuffer", circular buffer of the last N tri-axial samples
+//! (each sample is written twice, in column i and i+N, so that the last N
+//! samples are always stored in N contiguous columns)
+class SampleBuffer
+{
+	private:
+		rmat storage;			//!< 3x2N storage of the samples (one per column)
+		int N;					//!< size of the buffer
+		int next;				//!< column in which the next sample is written
+		int numWritten;			//!< number of samples written in the buffer
+
+	public:
+		//! constructor
+		//! @param[in] n	size of the buffer
+		SampleBuffer(int n = 0)
+		{
+			resize(n);
+		}
+
+		//! empty the buffer and set its size
+		//! @param[in] n	size of the buffer
+		void resize(int n)
+		{
+			N = n;
+			storage = zeros<rmat>(3, 2 * N);
+			next = 0;
+			numWritten = 0;
+		}
+
+		//! set the size of the buffer, keeping the most recent samples
+		//! (as many as fit in the new size)
+		//! @param[in] n	size of the buffer
+		void resizeKeep(int n)
+		{
+			int kept = (stored() < n) ? stored() : n;
+			rmat recent = zeros<rmat>(3, kept);
+			for (int k = 0; k < kept; k++)
+			{
+				const real_t* p = sample(stored() - kept + k);
+				recent(0, k) = p[0];
+				recent(1, k) = p[1];
+				recent(2, k) = p[2];
+			}
+			resize(n);
+			for (int k = 0; k < kept; k++)
+				push(recent(0, k), recent(1, k), recent(2, k));
+		}
+
+		//! add one sample to the buffer, overwriting the oldest one (O(1))
+		//! @param[in] x	first component of the sample
+		//! @param[in] y	second component of the sample
+		//! @param[in] z	third component of the sample
+		void push(real_t x, real_t y, real_t z)
+		{
+			real_t* first = storage.colptr(next);
+			real_t* second = storage.colptr(next + N);
+			first[0] = second[0] = x;
+			first[1] = second[1] = y;
+			first[2] = second[2] = z;
+			next = (next + 1 == N) ? 0 : next + 1;
+			numWritten = numWritten + 1;
+		}
+
+		//! add one sample to the buffer, overwriting the oldest one (O(1))
+		//! @param[in] &one_sample	reference to the sample (1x3 or 3x1)
+		void push(const mat &one_sample)
+		{
+			push(one_sample(0), one_sample(1), one_sample(2));
+		}
+
+		//! get the size of the buffer
+		//! @return		size of the buffer
+		int size() const
+		{
+			return N;
+		}
+
+		//! get the number of samples written since the last resize
+		//! @return		number of written samples
+		int count() const
+		{
+			return numWritten;
+		}
+
+		//! get the number of samples actually stored (at most N)
+		//! @return		number of stored samples
+		int stored() const
+		{
+			return (numWritten < N) ? numWritten : N;
+		}
+
+		//! get a pointer to one of the stored samples
+		//! @param[in] k	index of the sample (0: oldest stored, stored()-1: newest)
+		//! @return			pointer to the first element of the sample
+		const real_t* sample(int k) const
+		{
+			return storage.colptr(next + N - stored() + k);
+		}
+
+		//! check whether the buffer holds N samples
+		//! @return		true if the buffer is full
+		bool isFull() const
+		{
+			return (numWritten >= N);
+		}
+
+		//! get a pointer to the last N samples (oldest first, 3xN column-wise)
+		//! @return		pointer to the first element of the oldest sample
+		const real_t* memptr() const
+		{
+			return storage.colptr(next);
+		}
+
+		//! get a pointer to the newest sample
+		//! @return		pointer to the first element of the newest sample
+		const real_t* last() const
+		{
+			return storage.colptr(next + N - 1);
+		}
+
+		//! get a 3xN view of the last N samples (oldest first)
+		//! (the matrix uses the buffer memory: no copy is performed)
+		//! @return		matrix of the last N samples, one per column
+		const rmat view() const
+		{
+			return rmat(const_cast<real_t*>(memptr()), 3, N, false, true);
+		}
+
+		//! destructor
+		~SampleBuffer()
+		{
+			//DEBUG:cout<<endl <<"Destroying SampleBuffer object" <<endl;
+		}
+};
+
+#endif
@@ -0,0 +1,63 @@
+//===============================================================================//
+// Name			: scorer.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Incremental (sample-by-sample) scoring of sliding windows
+//===============================================================================//
+
+#include "scorer.hpp"
+
+//! constructor
+//! @param[in] &s	reference to the set of considered models
+//! @param[in] ws	size of the windows (size of the largest model)
+IncrementalScorer::IncrementalScorer(const vector<DYmodel> &s, int ws)
+{
+	set = &s;
+	nbM = s.size();
+	window_size = ws;
+	reset();
+}
+
+//! reset the partial sums
+void IncrementalScorer::reset()
+{
+	numPushed = 0;
+	sums.assign(nbM, vector<double>(window_size, 0));
+	distances.assign(nbM, 0);
+	distG.assign(window_size, 0);
+	distB.assign(window_size, 0);
+}
+
+//! add one feature sample (gravity and body acc.)
+//! (the window ending with sample t compares the model point j with sample
+//! t-window_size+1+j, hence sample s contributes to window s+window_size-1-j)
+//! @param[in] *gravity	pointer to the gravity sample (x,y,z)
+//! @param[in] *body	pointer to the body acc. sample (x,y,z)
+void IncrementalScorer::push(const real_t* gravity, const real_t* body)
+{
+	int s = numPushed;
+	for (int i = 0; i < nbM; i++)
+	{
+		const DYmodel &MODEL = (*set)[i];
+		double* ring = &sums[i][0];
+		double wG = MODEL.gravityWeight / (double) MODEL.size;
+		double wB = MODEL.bodyWeight / (double) MODEL.size;
+
+		// distance of the sample from every model point, added to its window
+		MODEL.gK.distances(gravity, &distG[0]);
+		MODEL.bK.distances(body, &distB[0]);
+		int slot = (s + window_size - 1) % window_size;
+		for (int j = 0; j < MODEL.size; j++)
+		{
+			ring[slot] += wG * distG[j] + wB * distB[j];
+			slot = (slot == 0) ? window_size - 1 : slot - 1;
+		}
+
+		// the window ending with this sample is complete: read and free its slot
+		int last = s % window_size;
+		distances[i] = ring[last];
+		ring[last] = 0;
+	}
+	numPushed = numPushed + 1;
+}
@@ -0,0 +1,66 @@
+//===============================================================================//
+// Name			: scorer.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Incremental (sample-by-sample) scoring of sliding windows
+//===============================================================================//
+
+#include <vector>
+
+#include "classifier.hpp"
+
+using namespace std;
+
+#ifndef SCORER_HPP_
+#define SCORER_HPP_
+
+//! class "IncrementalScorer" for the scoring of sliding windows of causal features
+//! (the distances of each feature sample from the model points are computed
+//! once, and accumulated in the partial sums of the windows it belongs to)
+class IncrementalScorer
+{
+	private:
+		const vector<DYmodel>* set;		//!< set of considered models
+		int nbM;						//!< number of considered models
+		int window_size;				//!< size of the windows
+		int numPushed;					//!< number of feature samples received
+		vector< vector<double> > sums;	//!< partial sums of the next windows
+										//!< (one ring of window_size per model)
+		vector<float> distances;		//!< distances of the last complete window
+		vector<real_t> distG;			//!< gravity distances of the new sample
+		vector<real_t> distB;			//!< body acc. distances of the new sample
+
+	public:
+		//! constructor
+		IncrementalScorer(const vector<DYmodel> &s, int ws);
+
+		//! reset the partial sums
+		void reset();
+
+		//! add one feature sample (gravity and body acc.)
+		void push(const real_t* gravity, const real_t* body);
+
+		//! check whether a complete window has been scored
+		//! @return		true if the last window is complete
+		bool isFull() const
+		{
+			return (numPushed >= window_size);
+		}
+
+		//! get the distance between the last window and one model
+		//! @param[in] i	index of the model
+		//! @return			overall distance between the window and the model
+		float distance(int i) const
+		{
+			return distances[i];
+		}
+
+		//! destructor
+		~IncrementalScorer()
+		{
+			//DEBUG:cout<<endl <<"Destroying IncrementalScorer object" <<endl;
+		}
+};
+
+#endif
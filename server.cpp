@@ -0,0 +1,120 @@
+//===============================================================================//
+// Name			: server.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Multi-wearer classification server (shared set of models)
+//===============================================================================//
+
+#include <boost/bind/bind.hpp>
+
+#include "server.hpp"
+
+//! constructor
+//! @param[in] &e	reference to the classifier (shared set of models)
+//! @param[in] nT	number of worker threads
+Server::Server(Classifier &e, int nT) : engine(e)
+{
+	busy = 0;
+	stop = false;
+	if (nT < 1)
+		nT = 1;
+	for (int i = 0; i < nT; i++)
+		workers.create_thread(boost::bind(&Server::work, this));
+}
+
+//! main loop of one worker thread
+void Server::work()
+{
+	deque<mat> samples;
+	while (true)
+	{
+		Session* s;
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			while (!stop && ready.empty())
+				wake.wait(guard);
+			if (stop)
+				return;
+			s = ready.front();
+			ready.pop_front();
+			samples.swap(s->inbox);
+			busy = busy + 1;
+		}
+
+		// classify the samples of the session (in order)
+		for (unsigned int i = 0; i < samples.size(); i++)
+		{
+			if (engine.classifySample(samples[i], *s))
+				engine.publishDynamic(*s, s->pub);
+		}
+		samples.clear();
+
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			busy = busy - 1;
+			if (s->inbox.empty())
+				s->scheduled = false;
+			else
+				ready.push_back(s);
+			if (ready.empty() && busy == 0)
+				idle.notify_all();
+		}
+		wake.notify_one();
+	}
+}
+
+//! open the session of a new wearer
+//! @param[in] p	interface for the publishing middleware of the wearer
+//! @return			identifier of the session
+int Server::openSession(Publisher* p)
+{
+	bool incremental = (engine.scoring == Classifier::INCREMENTAL);
+	Session* s = new Session(0, engine.currentSet(), incremental, p);
+
+	boost::unique_lock<boost::mutex> guard(lock);
+	s->id = sessions.size();
+	sessions.push_back(s);
+	return s->id;
+}
+
+//! add one raw sample to the stream of a wearer
+//! @param[in] id			identifier of the session
+//! @param[in] &one_sample	reference to the sample
+void Server::push(int id, const mat &one_sample)
+{
+	{
+		boost::unique_lock<boost::mutex> guard(lock);
+		Session* s = sessions[id];
+		s->inbox.push_back(one_sample);
+		if (s->scheduled)
+			return;
+		s->scheduled = true;
+		ready.push_back(s);
+	}
+	wake.notify_one();
+}
+
+//! wait until all the received samples have been classified
+void Server::drain()
+{
+	boost::unique_lock<boost::mutex> guard(lock);
+	while (!ready.empty() || busy > 0)
+		idle.wait(guard);
+}
+
+//! destructor (stops and joins the workers, closes the sessions)
+Server::~Server()
+{
+	{
+		boost::unique_lock<boost::mutex> guard(lock);
+		stop = true;
+	}
+	wake.notify_all();
+	workers.join_all();
+
+	for (unsigned int i = 0; i < sessions.size(); i++)
+		delete sessions[i];
+	sessions.clear();
+	//DEBUG:cout<<endl <<"Destroying Server object" <<endl;
+}
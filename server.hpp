@@ -0,0 +1,89 @@
+//===============================================================================//
+// Name			: server.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Multi-wearer classification server (shared set of models)
+//===============================================================================//
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include "classifier.hpp"
+
+using namespace arma;
+using namespace std;
+
+#ifndef SERVER_HPP_
+#define SERVER_HPP_
+
+//! class "Session", classification state and publisher of one wearer
+class Session : public Stream
+{
+	public:
+		int id;					//!< identifier of the session
+		Publisher* pub;			//!< interface for the publishing middleware
+		deque<mat> inbox;		//!< samples waiting to be classified
+		bool scheduled;			//!< flag --> session queued for a worker
+
+		//! constructor
+		//! @param[in] i			identifier of the session
+		//! @param[in] models		shared set of models to be recognized
+		//! @param[in] incremental	flag --> allocate the running sums
+		//! @param[in] p			interface for the publishing middleware
+		Session(int i, boost::shared_ptr<const ModelSet> models, bool incremental,
+				Publisher* p)
+			: Stream(models, incremental)
+		{
+			id = i;
+			pub = p;
+			scheduled = false;
+		}
+
+		//! destructor
+		~Session()
+		{
+			//DEBUG:cout<<endl <<"Destroying Session object" <<endl;
+		}
+};
+
+//! class "Server", classification of the streams of many wearers
+//! (the models are shared by all the sessions and never copied; each session
+//! is processed by one worker at a time, so that its samples are classified
+//! in order, while different sessions are processed concurrently)
+class Server
+{
+	private:
+		Classifier &engine;				//!< classifier (models, scoring mode)
+		vector<Session*> sessions;		//!< open sessions
+		deque<Session*> ready;			//!< sessions with samples to be classified
+		boost::thread_group workers;	//!< worker threads
+		boost::mutex lock;				//!< lock of the sessions and queue status
+		boost::condition_variable wake;	//!< signals a ready session (or stop)
+		boost::condition_variable idle;	//!< signals that all sessions are drained
+		int busy;						//!< number of sessions being processed
+		bool stop;						//!< flag --> terminate the workers
+
+		//! main loop of one worker thread
+		void work();
+
+	public:
+		//! constructor
+		Server(Classifier &e, int nT);
+
+		//! open the session of a new wearer
+		int openSession(Publisher* p);
+
+		//! add one raw sample to the stream of a wearer
+		void push(int id, const mat &one_sample);
+
+		//! wait until all the received samples have been classified
+		void drain();
+
+		//! destructor (stops and joins the workers, closes the sessions)
+		~Server();
+};
+
+#endif
@@ -0,0 +1,124 @@
+//===============================================================================//
+// Name			: shmpublisher.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Interface for the shared-memory ring (co-located consumers)
+//===============================================================================//
+
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shmpublisher.hpp"
+
+//! constructor
+//! (call to Publisher::Publisher constructor)
+//! @param[in] n		name of the publisher (ring in /dev/shm, e.g. "/hmpdetector")
+//! @param[in] capacity	number of records kept in the ring (rounded to a power of 2)
+//! @param[in] maxM		max number of models per record (the others are not written)
+ShmPublisher::ShmPublisher(string n, unsigned int capacity, unsigned int maxM)
+	: Publisher(n)
+{
+	map = NULL;
+	head = 0;
+	unsigned int slotCount = 1;
+	while (slotCount < capacity)
+		slotCount = slotCount * 2;
+	size_t slotSize = SHM_RECORD_FIXED + maxM * sizeof(float);
+	slotSize = (slotSize + 63) / 64 * 64;
+	length = sizeof(ShmRingHeader) + maxM * SHM_NAME_SIZE
+			 + (size_t) slotCount * slotSize;
+
+	// (a ring left by a previous run is replaced: its readers keep the old one)
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0 || ftruncate(fd, length) != 0)
+	{
+		cerr<<"Cannot create shared-memory ring: " <<name <<endl;
+		if (fd >= 0)
+			close(fd);
+		return;
+	}
+	void* m = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+	{
+		cerr<<"Cannot map shared-memory ring: " <<name <<endl;
+		shm_unlink(name.c_str());
+		return;
+	}
+	map = (char*) m;
+
+	// (the new file is zero-filled: no record is complete yet)
+	header = (ShmRingHeader*) map;
+	table = map + sizeof(ShmRingHeader);
+	slots = table + maxM * SHM_NAME_SIZE;
+	header->version = 1;
+	header->capacity = slotCount;
+	header->slotSize = slotSize;
+	header->maxModels = maxM;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(header->magic, "HMPRING1", 8);
+}
+
+//! publish information (not carried by the ring: key and value are ignored)
+void ShmPublisher::publish(const string /*key*/, const string /*value*/)
+{
+}
+
+//! publish the static information (names table of the ring)
+//! @param[in] &m      reference to the static information
+void ShmPublisher::publishModels(const ModelsRecord &m)
+{
+	if (map == NULL)
+		return;
+	uint64_t seq = header->namesSeq;
+	__atomic_store_n(&header->namesSeq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	unsigned int n = min((unsigned int) m.nbM, header->maxModels);
+	memset(table, 0, header->maxModels * SHM_NAME_SIZE);
+	for (unsigned int i = 0; i < n; i++)
+		strncpy(table + i * SHM_NAME_SIZE, m.names[i].c_str(), SHM_NAME_SIZE - 1);
+	header->nbNames = n;
+	__atomic_store_n(&header->namesSeq, seq + 2, __ATOMIC_RELEASE);
+}
+
+//! publish the dynamic information (one record of the ring)
+//! (the slot is marked as being written, filled, then marked as complete:
+//! the readers discard the copies taken in between)
+//! @param[in] &r      reference to the recognition results
+void ShmPublisher::publishResults(const ResultRecord &r)
+{
+	if (map == NULL)
+		return;
+	ShmRecord* slot = (ShmRecord*)
+		(slots + (size_t) (head & (header->capacity - 1)) * header->slotSize);
+	__atomic_store_n(&slot->seq, 2 * head + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	slot->timestamp = shmTimestamp();
+	slot->sample = r.sample;
+	slot->nbM = min((unsigned int) r.nbM, header->maxModels);
+	slot->best = (r.best < (int) slot->nbM) ? r.best : -1;
+	slot->secondBest = (r.secondBest < (int) slot->nbM) ? r.secondBest : -1;
+	slot->other = r.other();
+	slot->entropy = r.entropy();
+	memcpy(slot->possibilities, r.possibilities, slot->nbM * sizeof(float));
+	__atomic_store_n(&slot->seq, 2 * head + 2, __ATOMIC_RELEASE);
+	head = head + 1;
+	__atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+}
+
+//! destructor (removes the ring: the attached readers keep their mapping)
+ShmPublisher::~ShmPublisher()
+{
+	if (map != NULL)
+	{
+		munmap(map, length);
+		shm_unlink(name.c_str());
+	}
+	//DEBUG:cout<<endl <<"Destroying ShmPublisher object" <<endl;
+}
@@ -0,0 +1,59 @@
+//===============================================================================//
+// Name			: shmpublisher.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Interface for the shared-memory ring (co-located consumers)
+//===============================================================================//
+
+#include <string>
+
+#include "publisher.hpp"
+#include "shmring.hpp"
+
+using namespace std;
+
+#ifndef SHMPUBLISHER_HPP_
+#define SHMPUBLISHER_HPP_
+
+//! derivate class "ShmPublisher", interface for the shared-memory ring
+//! (the recognition results are written as fixed-layout records in a ring
+//! in /dev/shm, read by the co-located consumers with ShmRingReader:
+//! publishing is a copy in memory, never a system call, and never waits for
+//! the consumers; the string information is not carried by the ring)
+//! Single producer: one publisher per ring, used by one thread at a time
+class ShmPublisher: public Publisher
+{
+	private:
+		char* map;				//!< mapped ring (NULL: not available)
+		size_t length;			//!< length of the mapping
+		ShmRingHeader* header;	//!< header of the ring
+		char* table;			//!< names table of the ring
+		char* slots;			//!< slots of the ring
+		uint64_t head;			//!< number of records written
+
+		//! copy constructor (not allowed: the mapping is owned by the object)
+		ShmPublisher(const ShmPublisher &other);
+
+		//! assignment operator (not allowed: the mapping is owned by the object)
+		ShmPublisher& operator=(const ShmPublisher &other);
+
+	public:
+		//! constructor
+		ShmPublisher(string n = SHM_RING_NAME, unsigned int capacity = 1024,
+					 unsigned int maxM = 32);
+
+		//! publish information (not carried by the ring)
+		void publish(const string key, const string value);
+
+		//! publish the static information (names table of the ring)
+		void publishModels(const ModelsRecord &m);
+
+		//! publish the dynamic information (one record of the ring)
+		void publishResults(const ResultRecord &r);
+
+		//! destructor (removes the ring)
+		~ShmPublisher();
+};
+
+#endif
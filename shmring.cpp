@@ -0,0 +1,143 @@
+//===============================================================================//
+// Name			: shmring.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Shared-memory ring of recognition results (layout and reader)
+//===============================================================================//
+
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shmring.hpp"
+
+//! get the current time for the records
+//! @return		ns since the epoch
+uint64_t shmTimestamp()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//! attach to a ring (reading starts from the newest records)
+//! @param[in] name		name of the ring (in /dev/shm)
+//! @return				true if the ring is attached
+bool ShmRingReader::open(string name)
+{
+	close();
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(ShmRingHeader))
+	{
+		::close(fd);
+		return false;
+	}
+	length = info.st_size;
+	map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+	{
+		map = NULL;
+		return false;
+	}
+
+	// validate the layout
+	const ShmRingHeader* h = header();
+	if (memcmp(h->magic, "HMPRING1", 8) != 0 || h->version != 1
+		|| h->capacity == 0 || (h->capacity & (h->capacity - 1)) != 0
+		|| h->slotSize < SHM_RECORD_FIXED + h->maxModels * sizeof(float)
+		|| length < sizeof(ShmRingHeader) + h->maxModels * SHM_NAME_SIZE
+					+ (size_t) h->capacity * h->slotSize)
+	{
+		cerr<<"Invalid shared-memory ring: " <<name <<endl;
+		close();
+		return false;
+	}
+	copy.resize(h->slotSize);
+	next = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+	lost = 0;
+
+	return true;
+}
+
+//! get the names of the models (consistent copy of the names table)
+//! @param[out] &models	reference to the names of the models
+//! @return				true if the names have been read
+bool ShmRingReader::names(vector<string> &models) const
+{
+	const ShmRingHeader* h = header();
+	const char* table = (const char*) map + sizeof(ShmRingHeader);
+	for (int attempt = 0; attempt < 100; attempt++)
+	{
+		uint64_t before = __atomic_load_n(&h->namesSeq, __ATOMIC_ACQUIRE);
+		if (before % 2 == 1)
+			continue;
+		unsigned int n = h->nbNames;
+		if (n > h->maxModels)
+			n = h->maxModels;
+		models.resize(n);
+		for (unsigned int i = 0; i < n; i++)
+			models[i].assign(table + i * SHM_NAME_SIZE,
+							 strnlen(table + i * SHM_NAME_SIZE, SHM_NAME_SIZE));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&h->namesSeq, __ATOMIC_RELAXED) == before)
+			return true;
+	}
+
+	return false;
+}
+
+//! read the next record
+//! (records overwritten before being read are skipped and counted as lost)
+//! @return		pointer to a private copy of the record (NULL: no new record)
+const ShmRecord* ShmRingReader::read()
+{
+	const ShmRingHeader* h = header();
+	const char* slots = (const char*) map + sizeof(ShmRingHeader)
+						+ h->maxModels * SHM_NAME_SIZE;
+	while (true)
+	{
+		uint64_t head = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+		if (next >= head)
+			return NULL;
+		if (head - next > h->capacity)
+		{
+			// the producer lapped the reader: jump to the oldest record left
+			lost += head - h->capacity - next;
+			next = head - h->capacity;
+		}
+
+		// copy the slot, then check that it was not rewritten meanwhile
+		const ShmRecord* slot = (const ShmRecord*)
+			(slots + (size_t) (next & (h->capacity - 1)) * h->slotSize);
+		uint64_t expected = 2 * next + 2;
+		uint64_t before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		memcpy(&copy[0], slot, h->slotSize);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		uint64_t after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+		next = next + 1;
+		if (before == expected && after == expected)
+			return (const ShmRecord*) &copy[0];
+		lost = lost + 1;
+	}
+}
+
+//! detach from the ring
+void ShmRingReader::close()
+{
+	if (map != NULL)
+		munmap(map, length);
+	map = NULL;
+	length = 0;
+}
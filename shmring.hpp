@@ -0,0 +1,125 @@
+//===============================================================================//
+// Name			: shmring.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Shared-memory ring of recognition results (layout and reader)
+//===============================================================================//
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace std;
+
+#ifndef SHMRING_HPP_
+#define SHMRING_HPP_
+
+//! default name of the shared-memory ring (in /dev/shm)
+static const char* const SHM_RING_NAME = "/hmpdetector";
+
+//! max length of the name of a model in the ring (NUL included)
+static const int SHM_NAME_SIZE = 40;
+
+//! header of a shared-memory ring
+//! (64 bytes; the names table follows, then the slots)
+//! Single producer, many consumers: the producer never waits for the readers,
+//! which detect the records they missed (overwritten) and the torn ones
+struct ShmRingHeader
+{
+	char magic[8];			//!< "HMPRING1"
+	uint32_t version;		//!< version of the layout
+	uint32_t capacity;		//!< number of slots (power of 2)
+	uint32_t slotSize;		//!< size of one slot (bytes, multiple of 64)
+	uint32_t maxModels;		//!< max number of possibilities per record
+	uint64_t head;			//!< number of records written (atomic)
+	uint64_t namesSeq;		//!< seqlock of the names table (odd: being written)
+	uint32_t nbNames;		//!< number of names in the table
+	char reserved[20];		//!< reserved (zero)
+};
+
+//! fixed-layout record of a shared-memory ring (one per slot)
+//! (seq = 2*n+2 once record n is complete; odd while it is being written)
+struct ShmRecord
+{
+	uint64_t seq;			//!< seqlock of the slot
+	uint64_t timestamp;		//!< publication time (ns since the epoch)
+	int32_t sample;			//!< index of the last sample of the window
+	int32_t best;			//!< model with highest possibility (-1: none)
+	int32_t secondBest;		//!< model with second-highest possibility (-1: none)
+	uint32_t nbM;			//!< number of possibilities
+	float other;			//!< possibility that none of the models is occurring
+	float entropy;			//!< margin of the highest possibility (-1: none)
+	float possibilities[1];	//!< possibilities of the models (nbM values)
+};
+
+//! size of the fixed part of a record (bytes)
+static const size_t SHM_RECORD_FIXED = sizeof(ShmRecord) - sizeof(float);
+
+//! get the current time for the records (ns since the epoch)
+uint64_t shmTimestamp();
+
+//! class "ShmRingReader", consumer of a shared-memory ring (reader library)
+//! (each reader keeps its own position: readers never disturb the producer
+//! or each other)
+class ShmRingReader
+{
+	private:
+		void* map;				//!< mapped ring (NULL: not attached)
+		size_t length;			//!< length of the mapping
+		uint64_t next;			//!< number of the next record to be read
+		vector<char> copy;		//!< copy of the record being read
+
+		//! copy constructor (not allowed: the mapping is owned by the object)
+		ShmRingReader(const ShmRingReader &other);
+
+		//! assignment operator (not allowed: the mapping is owned by the object)
+		ShmRingReader& operator=(const ShmRingReader &other);
+
+		//! get the header of the ring
+		const ShmRingHeader* header() const
+		{
+			return (const ShmRingHeader*) map;
+		}
+
+	public:
+		unsigned long lost;		//!< records overwritten before being read
+
+		//! constructor
+		ShmRingReader()
+		{
+			map = NULL;
+			length = 0;
+			next = 0;
+			lost = 0;
+		}
+
+		//! attach to a ring (reading starts from the newest records)
+		bool open(string name = SHM_RING_NAME);
+
+		//! get the names of the models
+		bool names(vector<string> &models) const;
+
+		//! get the version of the names table (changes when it is rewritten)
+		//! @return		seqlock of the names table (odd: being written)
+		uint64_t namesVersion() const
+		{
+			return __atomic_load_n(&header()->namesSeq, __ATOMIC_ACQUIRE);
+		}
+
+		//! read the next record (the returned record is a private copy)
+		const ShmRecord* read();
+
+		//! detach from the ring
+		void close();
+
+		//! destructor (detaches from the ring)
+		~ShmRingReader()
+		{
+			close();
+			//DEBUG:cout<<endl <<"Destroying ShmRingReader object" <<endl;
+		}
+};
+
+#endif
@@ -0,0 +1,148 @@
+//===============================================================================//
+// Name			: triaxial.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Fixed-size tri-axial vector and 3x3 symmetric matrix (per-point math)
+//===============================================================================//
+
+#ifndef TRIAXIAL_HPP_
+#define TRIAXIAL_HPP_
+
+//! class "Vec3", tri-axial vector (stack-allocated, fully unrolled operations)
+template <typename T> class Vec3
+{
+	public:
+		T x;			//!< first component
+		T y;			//!< second component
+		T z;			//!< third component
+
+		//! constructor (components not initialized)
+		Vec3()
+		{
+		}
+
+		//! constructor with components initialization
+		//! @param[in] x0	first component
+		//! @param[in] y0	second component
+		//! @param[in] z0	third component
+		Vec3(T x0, T y0, T z0) : x(x0), y(y0), z(z0)
+		{
+		}
+
+		//! constructor from memory (x,y,z contiguous, e.g. one column of a 3xN matrix)
+		//! @param[in] *p	pointer to the first component
+		explicit Vec3(const T* p) : x(p[0]), y(p[1]), z(p[2])
+		{
+		}
+
+		//! store the vector in memory (x,y,z contiguous)
+		//! @param[out] *p	pointer to the first component
+		void store(T* p) const
+		{
+			p[0] = x;
+			p[1] = y;
+			p[2] = z;
+		}
+
+		//! component-wise sum
+		Vec3 operator+(const Vec3 &v) const
+		{
+			return Vec3(x + v.x, y + v.y, z + v.z);
+		}
+
+		//! component-wise difference
+		Vec3 operator-(const Vec3 &v) const
+		{
+			return Vec3(x - v.x, y - v.y, z - v.z);
+		}
+
+		//! scalar product
+		T dot(const Vec3 &v) const
+		{
+			return x*v.x + y*v.y + z*v.z;
+		}
+};
+
+//! class "SymMat3", 3x3 symmetric matrix (6 unique entries, stack-allocated)
+template <typename T> class SymMat3
+{
+	public:
+		T a00;			//!< entry (0,0)
+		T a01;			//!< entries (0,1) and (1,0)
+		T a02;			//!< entries (0,2) and (2,0)
+		T a11;			//!< entry (1,1)
+		T a12;			//!< entries (1,2) and (2,1)
+		T a22;			//!< entry (2,2)
+
+		//! constructor (entries not initialized)
+		SymMat3()
+		{
+		}
+
+		//! constructor with entries initialization
+		SymMat3(T e00, T e01, T e02, T e11, T e12, T e22)
+			: a00(e00), a01(e01), a02(e02), a11(e11), a12(e12), a22(e22)
+		{
+		}
+
+		//! symmetric part of a full 3x3 matrix (column-major, e.g. one cube slice)
+		//! @param[in] *m	pointer to the 9 entries of the matrix
+		//! @return			symmetric part of the matrix
+		template <typename S> static SymMat3 fromFull(const S* m)
+		{
+			return SymMat3(m[0], 0.5 * (m[3] + m[1]), 0.5 * (m[6] + m[2]),
+						   m[4], 0.5 * (m[7] + m[5]), m[8]);
+		}
+
+		//! store the full 3x3 matrix in memory (column-major)
+		//! @param[out] *m	pointer to the 9 entries of the matrix
+		template <typename S> void storeFull(S* m) const
+		{
+			m[0] = a00;	m[3] = a01;	m[6] = a02;
+			m[1] = a01;	m[4] = a11;	m[7] = a12;
+			m[2] = a02;	m[5] = a12;	m[8] = a22;
+		}
+
+		//! determinant of the matrix
+		T determinant() const
+		{
+			return a00 * (a11*a22 - a12*a12)
+				 - a01 * (a01*a22 - a12*a02)
+				 + a02 * (a01*a12 - a11*a02);
+		}
+
+		//! inverse of the matrix (adjugate over determinant, symmetric as well)
+		//! @return		inverse matrix (infinite entries if the matrix is singular)
+		SymMat3 inverse() const
+		{
+			T c00 = a11*a22 - a12*a12;
+			T c01 = a02*a12 - a01*a22;
+			T c02 = a01*a12 - a02*a11;
+			T invDet = 1 / (a00*c00 + a01*c01 + a02*c02);
+
+			return SymMat3(c00 * invDet, c01 * invDet, c02 * invDet,
+						   (a00*a22 - a02*a02) * invDet,
+						   (a01*a02 - a00*a12) * invDet,
+						   (a00*a11 - a01*a01) * invDet);
+		}
+
+		//! matrix-vector product
+		Vec3<T> operator*(const Vec3<T> &v) const
+		{
+			return Vec3<T>(a00*v.x + a01*v.y + a02*v.z,
+						   a01*v.x + a11*v.y + a12*v.z,
+						   a02*v.x + a12*v.y + a22*v.z);
+		}
+
+		//! quadratic form d' * A * d (Mahalanobis distance with A = inverse covariance)
+		//! @param[in] &d	reference to the difference vector
+		//! @return			value of the quadratic form
+		T quadraticForm(const Vec3<T> &d) const
+		{
+			return a00*d.x*d.x + a11*d.y*d.y + a22*d.z*d.z
+				 + 2 * (a01*d.x*d.y + a02*d.x*d.z + a12*d.y*d.z);
+		}
+};
+
+#endif
@@ -6,9 +6,16 @@
 // Description	: Frequently used functions (for Creator and Classifier)
 //===============================================================================//
 
-#include "libs/DspFilters/ChebyshevI.h"
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
 #include "utils.hpp"
 
+using namespace std;
+
 //! create a row-vector of the form: start:1:stop
 //! @param[in] start	starting value of the interval (fixed increment by 1)
 //! @param[in] stop		ending value of the interval
@@ -60,78 +67,243 @@ mat floatToMat(float** matrix, int Nrows, int Ncols)
 }
 
 //! compute the median value of a vector
+//! (element of rank n/2: the upper median for even sizes)
 //! @param[in] &vector	reference to the vector to get the median from
 //! @return			    median of vector
-double median(rowvec &vector)
+template <typename eT> eT median(Row<eT> &vector)
 {
-	int min = 0;
-	rowvec tempVec = vector;
+	Row<eT> tempVec = vector;
+	eT* first = tempVec.memptr();
+	nth_element(first, first + vector.n_cols / 2, first + vector.n_cols);
 
-	for (unsigned int i = 0; i < vector.n_cols; i++)
-	{
-		min = i;
-		for (unsigned int j = i; j < vector.n_cols; j++)
+	return tempVec(vector.n_cols / 2);
+}
+
+//! class "SlidingMedian", running median of a window of fixed size
+//! (sorted window and iterator on the element of rank size/2: each slide
+//! costs O(log size))
+template <typename eT> class SlidingMedian
+{
+	private:
+		multiset<eT> window;						//!< sorted window
+		typename multiset<eT>::iterator mid;		//!< element of rank size/2
+
+	public:
+		//! constructor
+		//! @param[in] *first	pointer to the first values of the window
+		//! @param[in] size		size of the window
+		SlidingMedian(const eT* first, int size): window(first, first + size)
+		{
+			mid = window.begin();
+			advance(mid, size / 2);
+		}
+
+		//! get the median of the window
+		//! @return		element of rank size/2
+		eT median() const
+		{
+			return *mid;
+		}
+
+		//! slide the window by one value
+		//! @param[in] in	value entering the window
+		//! @param[in] out	value leaving the window
+		void slide(eT in, eT out)
 		{
-			if (tempVec(min) > tempVec(j))
-				min = j;
+			window.insert(in);
+			if (in < *mid)
+				--mid;
+			if (!(*mid < out))
+				++mid;
+			window.erase(window.lower_bound(out));
 		}
+};
 
-		double temp = tempVec(i);
-		tempVec(i) = tempVec(min);
-		tempVec(min) = temp;
+//! perform median filtering on a sequence (in place, strided)
+//! (centered window, zero-padded at both ends: size 3 uses the sorting
+//! network, larger sizes the sliding median)
+//! @param[in,out] *data	pointer to the first value of the sequence
+//! @param[in] n			number of values in the sequence
+//! @param[in] stride		distance between two values (1: contiguous)
+//! @param[in] size			size of the median filter (odd)
+template <typename eT> void medianFilter(eT* data, int n, int stride, int size)
+{
+	int step = size / 2;
+	if (n <= 0 || step <= 0)
+		return;
+
+	// size 3: the previous raw value is the only one to be kept
+	if (step == 1)
+	{
+		eT previous = 0;
+		for (int i = 0; i < n; i++)
+		{
+			eT current = data[i * stride];
+			eT next = (i + 1 < n) ? data[(i + 1) * stride] : 0;
+			data[i * stride] = median3(previous, current, next);
+			previous = current;
+		}
+		return;
 	}
 
-	return tempVec(vector.n_cols / 2);
+	// zero-padded copy of the raw values (the window slides on it)
+	vector<eT> padded(n + 2 * step, 0);
+	for (int i = 0; i < n; i++)
+		padded[step + i] = data[i * stride];
+	SlidingMedian<eT> running(&padded[0], 2 * step + 1);
+	for (int i = 0; i < n; i++)
+	{
+		if (i > 0)
+			running.slide(padded[i + 2 * step], padded[i - 1]);
+		data[i * stride] = running.median();
+	}
 }
 
 //! perform median filtering on a matrix
+//! (each row is filtered in place: one sample per column)
 //! @param[in/out] &matrix	reference to the matrix to be filtered
-//! @param[in] size 		size of the median filter
-void medianFilter(mat &matrix, int size)
+//! @param[in] size 		size of the median filter (odd)
+template <typename eT> void medianFilter(Mat<eT> &matrix, int size)
 {
-	unsigned int step = size / 2;
-	mat tempMat = matrix;
-
 	for (unsigned int r = 0; r < matrix.n_rows; r++)
+		medianFilter(matrix.memptr() + r, matrix.n_cols, matrix.n_rows, size);
+}
+
+//! design the cascade of the filter (and reset the state)
+//! @param[in] &c	reference to the configuration of the filter
+void GravityFilter::configure(const FilterConfig &c)
+{
+	if (c.samplingRate <= 0 || c.cutoff <= 0 || c.cutoff >= c.samplingRate / 2
+		|| c.ripple <= 0)
+		throw runtime_error("invalid gravity filter configuration");
+	ChebyshevLowPass design;
+	design.setup(ORDER, c.samplingRate, c.cutoff, c.ripple);
+	lanes.setup(design);
+	current = c;
+}
+
+//! read the configuration of the gravity filter of a dataset
+//! (sampling rate [Hz], cutoff frequency [Hz] and pass-band ripple [dB];
+//! datasets without the file use the default configuration)
+//! @param[in] fileName	name of the configuration file (Filterconfig.txt)
+//! @return				configuration of the filter
+FilterConfig readFilterConfig(string fileName)
+{
+	FilterConfig config;
+	ifstream configFile(fileName.c_str());
+	if (!configFile)
+		return config;
+	configFile >>config.samplingRate >>config.cutoff >>config.ripple;
+	if (!configFile)
+		throw runtime_error("malformed config file: " + fileName);
+	configFile.close();
+
+	return config;
+}
+
+//! apply ChebyshevI filter on a matrix (in place)
+//! (the 3 axes are filtered directly in the matrix memory, in its own
+//! precision; the filter state is kept: reset it for independent windows)
+//! @param[in,out] &matrix	reference to the matrix to be filtered (3xN, one
+//!							sample per column)
+//! @param[in,out] &filter	reference to the (designed) filter
+template <typename eT> void ChebyshevFilter(Mat<eT> &matrix, GravityFilter &filter)
+{
+	filter.processStrided(matrix.n_cols, matrix.memptr(), matrix.n_rows, 1);
+}
+
+//! number of samples extracted per block (the block stays in cache between
+//! the median, the low-pass filter and the body acc. subtraction)
+static const int FEATURE_BLOCK = 64;
+
+//! extract gravity and body acc. features from raw samples (single pass)
+//! (median filtering, ChebyshevI low-pass filtering and body acc. extraction
+//! in one pass over blocks of samples: same results as medianFilter, then
+//! ChebyshevFilter, then body = clean - gravity; the filter state is reset,
+//! and the outputs must have the layout of the raw samples and not alias them)
+//! @param[in] *raw			pointer to the first axis of the first raw sample
+//! @param[in] n			number of samples
+//! @param[in] sampleStride	distance between two samples of an axis
+//! @param[in] axisStride	distance between two axes of a sample
+//! @param[in] medianSize	size of the median filter (odd)
+//! @param[in,out] &filter	reference to the (designed) low-pass filter
+//! @param[out] *gravity	pointer to the gravity feature (same layout as raw)
+//! @param[out] *body		pointer to the body acc. feature (same layout as raw)
+template <typename eT> void extractFeatures(const eT* raw, int n, int sampleStride,
+											int axisStride, int medianSize,
+											GravityFilter &filter, eT* gravity,
+											eT* body)
+{
+	filter.reset();
+
+	// size 3: the sorting network runs on the raw samples, block by block;
+	// other sizes: the sliding median cleans the whole sequence first
+	bool network = (medianSize == 3);
+	if (!network)
 	{
-		for (unsigned int i = 0; i < matrix.n_cols; i++)
+		for (int a = 0; a < 3; a++)
 		{
-			mat window = zeros<mat>(1, size);
+			for (int i = 0; i < n; i++)
+			{
+				int k = i * sampleStride + a * axisStride;
+				body[k] = raw[k];
+			}
+			medianFilter(body + a * axisStride, n, sampleStride, medianSize);
+		}
+	}
+
+	for (int start = 0; start < n; start += FEATURE_BLOCK)
+	{
+		int stop = (n - start < FEATURE_BLOCK) ? n : start + FEATURE_BLOCK;
 
-			if (i >= step && i <= (matrix.n_cols - 1 - step))
-				window = matrix.submat(r, i - step, r, i + step);
-			else
+		// clean samples (median), copied in both features
+		for (int i = start; i < stop; i++)
+		{
+			for (int a = 0; a < 3; a++)
 			{
-				if (i < step)
-					window.submat(0,step,0,size-1) = matrix.submat(r,0,r,step);
+				int k = i * sampleStride + a * axisStride;
+				eT clean;
+				if (network)
+				{
+					eT previous = (i > 0) ? raw[k - sampleStride] : 0;
+					eT next = (i + 1 < n) ? raw[k + sampleStride] : 0;
+					clean = median3(previous, raw[k], next);
+				}
 				else
-					if (i > (matrix.n_cols - 1 - step))
-						window.submat(0, 0, 0, step) = 
-							matrix.submat(r, i - step, r, matrix.n_cols - 1);
+					clean = body[k];
+				gravity[k] = clean;
+				body[k] = clean;
 			}
-			rowvec medianRow = window.row(0);
-			tempMat(r, i) = median(medianRow);
 		}
-	}
 
-	matrix = tempMat;
+		// gravity (low-pass, state carried to the next block), then body acc.
+		filter.processStrided(stop - start, gravity + start * sampleStride,
+							  sampleStride, axisStride);
+		for (int i = start; i < stop; i++)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				int k = i * sampleStride + a * axisStride;
+				body[k] -= gravity[k];
+			}
+		}
+	}
 }
 
-//! apply ChebyshevI filter on a matrix
-//! @param[in] matrix	matrix to be filtered
-//! @return 			filtered matrix
-mat ChebyshevFilter(mat matrix)
-{
-	float **floatMatrix = matToFloat(matrix);
-	Dsp::SimpleFilter<Dsp::ChebyshevI::LowPass<5>,3> filter;
-	int filterOrder = 2;
-	int samplingFreq = 32;
-	float cutFreq = 0.25;
-	float passRipple = 0.001;
-
-	filter.setup(filterOrder, samplingFreq, cutFreq, passRipple);
-	filter.process(matrix.n_cols, floatMatrix);
-	mat lowpassComponent = floatToMat(floatMatrix, matrix.n_rows, matrix.n_cols);
-
-	return lowpassComponent;
-}
+// instantiations for the double (Creator) and single precision pipelines
+template double median<double>(Row<double> &vector);
+template float median<float>(Row<float> &vector);
+template void medianFilter<double>(double* data, int n, int stride, int size);
+template void medianFilter<float>(float* data, int n, int stride, int size);
+template void medianFilter<double>(Mat<double> &matrix, int size);
+template void medianFilter<float>(Mat<float> &matrix, int size);
+template void ChebyshevFilter<double>(Mat<double> &matrix, GravityFilter &filter);
+template void ChebyshevFilter<float>(Mat<float> &matrix, GravityFilter &filter);
+template void extractFeatures<double>(const double* raw, int n, int sampleStride,
+									  int axisStride, int medianSize,
+									  GravityFilter &filter, double* gravity,
+									  double* body);
+template void extractFeatures<float>(const float* raw, int n, int sampleStride,
+									 int axisStride, int medianSize,
+									 GravityFilter &filter, float* gravity,
+									 float* body);
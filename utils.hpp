@@ -6,13 +6,154 @@
 // Description	: Frequently used functions (for Creator and Classifier)
 //===============================================================================//
 
+#include <string>
+
 #include <armadillo>
 
+#include "libs/DspFilters/ChebyshevI.h"
+#include "libs/DspFilters/Interleaved.h"
+
 using namespace arma;
+using namespace std;
 
 #ifndef UTILS_HPP_
 #define UTILS_HPP_
 
+//! class "ChebyshevLowPass", ChebyshevI low-pass filter separating gravity
+//! from body acc. (3 channels, state kept across calls)
+class ChebyshevLowPass: public Dsp::SimpleFilter<Dsp::ChebyshevI::LowPass<5>,3>
+{
+	public:
+		//! process the 3 axes of a block of samples, in place (float or double)
+		//! (3xN matrices: sampleStride 3, axisStride 1; Nx3: 1 and N)
+		//! @param[in] numSamples		number of samples
+		//! @param[in,out] *data		pointer to the first axis of the first sample
+		//! @param[in] sampleStride		distance between two samples of an axis
+		//! @param[in] axisStride		distance between two axes of a sample
+		template <typename Sample>
+		void processStrided(int numSamples, Sample* data, int sampleStride,
+							int axisStride)
+		{
+			Sample* y = data + axisStride;
+			Sample* z = y + axisStride;
+			for (int i = 0; i < numSamples; i++)
+			{
+				int k = i * sampleStride;
+				data[k] = m_state[0].process(data[k], *this);
+				y[k] = m_state[1].process(y[k], *this);
+				z[k] = m_state[2].process(z[k], *this);
+			}
+		}
+};
+
+//! configuration of the filter separating gravity from body acc.
+//! (one per dataset: models and windows must be filtered alike)
+struct FilterConfig
+{
+	double samplingRate;	//!< sampling rate of the device (Hz)
+	double cutoff;			//!< cutoff frequency of the low-pass filter (Hz)
+	double ripple;			//!< pass-band ripple of the low-pass filter (dB)
+
+	//! constructor (default: the 32 Hz sensing devices)
+	FilterConfig()
+	{
+		samplingRate = 32;
+		cutoff = 0.25;
+		ripple = 0.001;
+	}
+
+	//! compare two configurations
+	//! @param[in] &other	reference to the other configuration
+	//! @return				true if the filters have the same design
+	bool operator==(const FilterConfig &other) const
+	{
+		return (samplingRate == other.samplingRate && cutoff == other.cutoff
+				&& ripple == other.ripple);
+	}
+};
+
+//! class "GravityFilter", low-pass filter separating gravity from body acc.
+//! (the ChebyshevI cascade is designed once, when the filter is configured,
+//! and its coefficients are reused by every call; the 3 axes are filtered
+//! together, one SIMD lane each, with the same results as the scalar
+//! ChebyshevLowPass; the filter contains its cascade: it is not a
+//! ChebyshevLowPass, whose state it would not use)
+class GravityFilter
+{
+	private:
+		FilterConfig current;	//!< configuration of the designed cascade
+		Dsp::InterleavedCascade lanes;	//!< cascade applied to the 3 axes at once
+
+	public:
+		static const int ORDER = 2;	//!< order of the low-pass filter
+
+		//! constructor
+		//! @param[in] &c	reference to the configuration of the filter
+		GravityFilter(const FilterConfig &c = FilterConfig())
+		{
+			configure(c);
+		}
+
+		//! copy constructor (same design, state reset)
+		//! @param[in] &other	reference to the filter to be copied
+		GravityFilter(const GravityFilter &other)
+			: current(other.current), lanes(other.lanes)
+		{
+			lanes.reset();
+		}
+
+		//! assignment operator (same design, state reset)
+		//! @param[in] &other	reference to the filter to be copied
+		//! @return				reference to this filter
+		GravityFilter& operator=(const GravityFilter &other)
+		{
+			current = other.current;
+			lanes = other.lanes;
+			lanes.reset();
+			return *this;
+		}
+
+		//! design the cascade (and reset the state)
+		void configure(const FilterConfig &c);
+
+		//! reset the state of the filter
+		void reset()
+		{
+			lanes.reset();
+		}
+
+		//! process the 3 axes of a block of samples, in place (float or double)
+		//! (3xN matrices: sampleStride 3, axisStride 1; Nx3: 1 and N)
+		//! @param[in] numSamples		number of samples
+		//! @param[in,out] *data		pointer to the first axis of the first sample
+		//! @param[in] sampleStride		distance between two samples of an axis
+		//! @param[in] axisStride		distance between two axes of a sample
+		template <typename Sample>
+		void processStrided(int numSamples, Sample* data, int sampleStride,
+							int axisStride)
+		{
+			lanes.process(numSamples, data, 3, sampleStride, axisStride);
+		}
+
+		//! get the configuration of the designed cascade
+		//! @return		configuration of the filter
+		const FilterConfig& config() const
+		{
+			return current;
+		}
+};
+
+//! floating point type of the classification pipeline (features and models)
+//! (build option HMP_FLOAT32: single precision, double precision otherwise)
+#ifdef HMP_FLOAT32
+typedef float real_t;
+#else
+typedef double real_t;
+#endif
+
+//! matrix of the classification pipeline (3xN features, one sample per column)
+typedef Mat<real_t> rmat;
+
 //===============================================================================//
 // BASIC MATRIX-HANDLING FUNCTIONS
 
@@ -30,13 +171,38 @@ mat floatToMat(float** matrix, int Nrows, int Ncols);
 // FILTERING FUNCTIONS
 
 //! compute the median value of a vector
-double median(rowvec &vector);
+template <typename eT> eT median(Row<eT> &vector);
+
+//! compute the median of three values (sorting network: min/max only)
+//! @param[in] a	first value
+//! @param[in] b	second value
+//! @param[in] c	third value
+//! @return			median of the three values
+template <typename eT> inline eT median3(eT a, eT b, eT c)
+{
+	eT low = (a < b) ? a : b;
+	eT high = (a < b) ? b : a;
+	eT mid = (high < c) ? high : c;
+	return (low < mid) ? mid : low;
+}
+
+//! perform median filtering on a sequence (in place, strided)
+template <typename eT> void medianFilter(eT* data, int n, int stride, int size);
 
 //! perform median filtering on a matrix
-void medianFilter(mat &matrix, int size);
+template <typename eT> void medianFilter(Mat<eT> &matrix, int size);
+
+//! read the configuration of the gravity filter of a dataset
+FilterConfig readFilterConfig(string fileName);
+
+//! apply ChebyshevI filter on a matrix (in place)
+template <typename eT> void ChebyshevFilter(Mat<eT> &matrix, GravityFilter &filter);
 
-//! apply ChebyshevI filter on a matrix
-mat ChebyshevFilter(mat matrix);
+//! extract gravity and body acc. features from raw samples (single pass)
+template <typename eT> void extractFeatures(const eT* raw, int n, int sampleStride,
+											int axisStride, int medianSize,
+											GravityFilter &filter, eT* gravity,
+											eT* body);
 //===============================================================================//
 
 #endif
@@ -0,0 +1,95 @@
+//===============================================================================//
+// Name			: workerpool.cpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Persistent pool of worker threads (fork-join jobs)
+//===============================================================================//
+
+#include <boost/bind/bind.hpp>
+
+#include "workerpool.hpp"
+
+//! constructor
+//! @param[in] nT	number of threads (caller included)
+WorkerPool::WorkerPool(int nT)
+{
+	nbThreads = (nT < 1) ? 1 : nT;
+	job = NULL;
+	generation = 0;
+	pending = 0;
+	stop = false;
+
+	for (int i = 1; i < nbThreads; i++)
+		workers.create_thread(boost::bind(&WorkerPool::work, this, i));
+}
+
+//! main loop of one worker thread
+//! @param[in] part		index of the job part executed by the worker
+void WorkerPool::work(int part)
+{
+	unsigned long seen = 0;
+	while (true)
+	{
+		Job* current;
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			while (!stop && generation == seen)
+				wake.wait(guard);
+			if (stop)
+				return;
+			seen = generation;
+			current = job;
+		}
+
+		current->run(part, nbThreads);
+
+		{
+			boost::unique_lock<boost::mutex> guard(lock);
+			pending = pending - 1;
+			if (pending == 0)
+				done.notify_one();
+		}
+	}
+}
+
+//! execute a job on all the threads and wait for its completion
+//! @param[in] &j	reference to the job
+void WorkerPool::run(Job &j)
+{
+	if (nbThreads == 1)
+	{
+		j.run(0, 1);
+		return;
+	}
+
+	// wake up the workers
+	boost::unique_lock<boost::mutex> turn(submit);
+	{
+		boost::unique_lock<boost::mutex> guard(lock);
+		job = &j;
+		pending = nbThreads - 1;
+		generation = generation + 1;
+	}
+	wake.notify_all();
+
+	// execute part 0 in the calling thread
+	j.run(0, nbThreads);
+
+	// wait for the other parts
+	boost::unique_lock<boost::mutex> guard(lock);
+	while (pending > 0)
+		done.wait(guard);
+	job = NULL;
+}
+
+//! destructor (stops and joins the workers)
+WorkerPool::~WorkerPool()
+{
+	{
+		boost::unique_lock<boost::mutex> guard(lock);
+		stop = true;
+	}
+	wake.notify_all();
+	workers.join_all();
+}
@@ -0,0 +1,71 @@
+//===============================================================================//
+// Name			: workerpool.hpp
+// Author(s)	: Barbara Bruno, Antonello Scalmato
+// Affiliation	: University of Genova, Italy - dept. DIBRIS
+// Version		: 1.0
+// Description	: Persistent pool of worker threads (fork-join jobs)
+//===============================================================================//
+
+#include <boost/thread.hpp>
+
+using namespace std;
+
+#ifndef WORKERPOOL_HPP_
+#define WORKERPOOL_HPP_
+
+//! class "WorkerPool", persistent pool of threads executing fork-join jobs
+//! (the threads are created once; the calling thread executes part 0 of
+//! each job, the workers the remaining parts)
+class WorkerPool
+{
+	public:
+		//! base class "Job" for the work executed by the pool
+		class Job
+		{
+			public:
+				//! execute one part of the job
+				//! @param[in] part		index of the part (0 <= part < nbParts)
+				//! @param[in] nbParts	number of parts of the job
+				virtual void run(int part, int nbParts) = 0;
+
+				//! destructor
+				virtual ~Job()
+				{
+				}
+		};
+
+	private:
+		int nbThreads;					//!< number of threads (caller included)
+		boost::thread_group workers;	//!< worker threads
+		boost::mutex lock;				//!< lock of the pool status
+		boost::mutex submit;			//!< serializes the jobs of concurrent callers
+		boost::condition_variable wake;	//!< signals a new job (or stop)
+		boost::condition_variable done;	//!< signals the end of a job part
+		Job* job;						//!< job being executed
+		unsigned long generation;		//!< number of submitted jobs
+		int pending;					//!< number of job parts still running
+		bool stop;						//!< flag --> terminate the workers
+
+		//! main loop of one worker thread
+		void work(int part);
+
+	public:
+		//! constructor
+		WorkerPool(int nT);
+
+		//! get the number of threads (caller included)
+		//! @return		number of threads executing each job
+		int size() const
+		{
+			return nbThreads;
+		}
+
+		//! execute a job on all the threads and wait for its completion
+		//! (concurrent callers are served one job at a time)
+		void run(Job &j);
+
+		//! destructor (stops and joins the workers)
+		~WorkerPool();
+};
+
+#endif